@@ -0,0 +1,539 @@
+//
+// PhasorBeatMapBench.cpp
+// Headless benchmark for PhasorBeatMap::process.
+//
+// Drives a single PhasorBeatMap instance directly, without an audio device or engine thread,
+// using synthetic phasor and CV streams. Every scenario is run once per sequencer mode and
+// reported as one JSON object per line:
+//
+//   {"scenario":"static","mode":"original","channels":1,"block":0,"samples":480000,"sample_rate":48000,
+//    "ns_per_sample":21.4,"cycles_per_sample":64.1,"regenerations":0,"regenerations_per_second":0}
+//
+// regenerations_per_second is measured against the processed audio time, so it reflects what
+// the module costs inside a running patch. cycles_per_sample is read from the time stamp counter
+// and reported as null on targets without one. With --channels N the phasor and CV inputs carry
+// N polyphonic channels, each phasor offset by 1/N of a bar; regenerations counts channel 0 only.
+// With --block N the timed loop bypasses process() and calls PhasorBeatMap::processBlock on N
+// frames at a time, refreshing parameters once per block.
+//
+// Before timing anything, the SIMD bar kernels are checked bit for bit against their scalar
+// reference over every map position and every (level, perturbation, threshold) combination, and
+// HCVPhasorResetDetector4 against four scalar HCVPhasorResetDetector lanes on fixed test vectors,
+// the step crossings of multi-step scrubs against their boundaries, and processBlock() on blocks of
+// frames against process() one frame at a time. The results are printed as {"check":"bar_kernels",...},
+// {"check":"reset_detectors",...}, {"check":"step_crossings",...} and {"check":"block_processing",...},
+// and a mismatch exits with status 1. --check runs the checks alone.
+//
+// Usage: PhasorBeatMapBench [--samples N] [--rate HZ] [--bar-hz HZ] [--channels N] [--block N] [--check]
+//
+
+#include "../src/PhasorBeatMap/PhasorBeatMap.hpp"
+#include "../src/PhasorBeatMap/PhasorBeatMapBarKernel.hpp"
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#else
+#define BENCH_HAS_TSC 0
+#endif
+
+Plugin* pluginInstance = nullptr;
+
+namespace {
+
+enum Scenario {
+    STATIC_PARAMS,
+    CV_MODULATION,
+    CHAOS_RESETS,
+    NUM_SCENARIOS
+};
+
+const char* scenarioNames[NUM_SCENARIOS] = {"static", "cv", "chaos"};
+const char* modeNames[PhasorBeatMap::NUM_SEQUENCER_MODES] = {"original", "henri", "euclidean"};
+
+const int cvInputs[] = {
+    PhasorBeatMap::MAPX_CV,
+    PhasorBeatMap::MAPY_CV,
+    PhasorBeatMap::CHAOS_CV,
+    PhasorBeatMap::BD_FILL_CV,
+    PhasorBeatMap::SN_FILL_CV,
+    PhasorBeatMap::HH_FILL_CV
+};
+const int numCVInputs = sizeof(cvInputs) / sizeof(cvInputs[0]);
+
+struct BenchSettings {
+    long samples = 480000;
+    float sampleRate = 48000.f;
+    float barHz = 2.f;
+    int channels = 1;
+    int block = 0;
+    bool checkOnly = false;
+};
+
+uint64_t readCycles() {
+#if BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+void setupModule(PhasorBeatMap& module, Scenario scenario, int mode, int channels) {
+    module.params[PhasorBeatMap::MODE_PARAM].setValue((float)mode);
+    module.params[PhasorBeatMap::MAPX_PARAM].setValue(0.3f);
+    module.params[PhasorBeatMap::MAPY_PARAM].setValue(0.6f);
+    module.params[PhasorBeatMap::CHAOS_PARAM].setValue(scenario == CHAOS_RESETS ? 1.f : 0.f);
+    module.params[PhasorBeatMap::BD_DENS_PARAM].setValue(0.5f);
+    module.params[PhasorBeatMap::SN_DENS_PARAM].setValue(0.5f);
+    module.params[PhasorBeatMap::HH_DENS_PARAM].setValue(0.5f);
+
+    module.inputs[PhasorBeatMap::PHASOR_INPUT].setChannels(channels);
+    for (int i = 0; i < numCVInputs; ++i) {
+        module.inputs[cvInputs[i]].setChannels(scenario == CV_MODULATION ? channels : 0);
+        for (int c = 0; c < channels; ++c) {
+            module.inputs[cvInputs[i]].setVoltage(0.f, c);
+        }
+    }
+    for (int i = 0; i < PhasorBeatMap::NUM_OUTPUTS; ++i) {
+        module.outputs[i].setChannels(channels);
+    }
+}
+
+// Runs one scenario and prints its report line.
+void runScenario(const BenchSettings& settings, Scenario scenario, int mode) {
+    PhasorBeatMap module;
+    const int channels = settings.channels;
+    setupModule(module, scenario, mode, channels);
+
+    Module::ProcessArgs args;
+    args.sampleRate = settings.sampleRate;
+    args.sampleTime = 1.f / settings.sampleRate;
+    args.frame = 0;
+
+    // Precompute the synthetic streams so the timed loop measures the module alone.
+    const float phasorIncrement = settings.barHz / settings.sampleRate;
+    const long blockSize = 4096;
+    std::vector<float> phasorBlock(channels * blockSize);
+    float cvBlock[numCVInputs][blockSize];
+    std::vector<float> outputBlock(PhasorBeatMap::NUM_OUTPUTS * blockSize);
+    std::vector<uint32_t> resetBlock(blockSize);
+    float* outs[PhasorBeatMap::NUM_OUTPUTS];
+    for (int i = 0; i < PhasorBeatMap::NUM_OUTPUTS; ++i) {
+        outs[i] = &outputBlock[i * blockSize];
+    }
+
+    // Warm up so the first bar generation is not counted.
+    module.inputs[PhasorBeatMap::PHASOR_INPUT].setVoltage(0.f);
+    module.process(args);
+    const uint32_t firstGeneration = module.barCache[0]->generation;
+
+    float phasor = 0.f;
+    double lfoPhase = 0.0;
+    long remaining = settings.samples;
+    std::chrono::nanoseconds elapsed(0);
+    uint64_t cycles = 0;
+
+    while (remaining > 0) {
+        const long n = std::min(remaining, blockSize);
+        for (long i = 0; i < n; ++i) {
+            for (int c = 0; c < channels; ++c) {
+                float channelPhasor = phasor + (float)c / channels;
+                if (channelPhasor >= 1.f) channelPhasor -= 1.f;
+                phasorBlock[c * blockSize + i] = channelPhasor;
+            }
+            phasor += phasorIncrement;
+            if (phasor >= 1.f) phasor -= 1.f;
+
+            // Each CV gets its own LFO rate so the regeneration checks see independent changes.
+            for (int c = 0; c < numCVInputs; ++c) {
+                cvBlock[c][i] = 5.f * (float)std::sin(lfoPhase * (c + 1));
+            }
+            lfoPhase += 2.0 * M_PI * 0.5 / settings.sampleRate;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t startCycles = readCycles();
+        if (settings.block > 0) {
+            for (long i = 0; i < n; i += settings.block) {
+                const int frames = (int)std::min((long)settings.block, n - i);
+                if (scenario == CV_MODULATION) {
+                    for (int cv = 0; cv < numCVInputs; ++cv) {
+                        for (int c = 0; c < channels; ++c) {
+                            module.inputs[cvInputs[cv]].setVoltage(cvBlock[cv][i], c);
+                        }
+                    }
+                }
+                module.processControlRate();
+                module.detectResets(&phasorBlock[i], blockSize, frames, resetBlock.data());
+                for (int c = 0; c < channels; ++c) {
+                    module.processBlock(&phasorBlock[c * blockSize + i], resetBlock.data(), frames, outs, c);
+                }
+            }
+        } else {
+            for (long i = 0; i < n; ++i) {
+                for (int c = 0; c < channels; ++c) {
+                    module.inputs[PhasorBeatMap::PHASOR_INPUT].setVoltage(phasorBlock[c * blockSize + i] * 10.f, c);
+                }
+                if (scenario == CV_MODULATION) {
+                    for (int cv = 0; cv < numCVInputs; ++cv) {
+                        for (int c = 0; c < channels; ++c) {
+                            module.inputs[cvInputs[cv]].setVoltage(cvBlock[cv][i], c);
+                        }
+                    }
+                }
+                ++args.frame;
+                module.process(args);
+            }
+        }
+        cycles += readCycles() - startCycles;
+        elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        remaining -= n;
+    }
+
+    const double samples = (double)settings.samples;
+    const double audioSeconds = samples / settings.sampleRate;
+    const uint32_t regenerations = module.barCache[0]->generation - firstGeneration;
+
+    std::printf("{\"scenario\":\"%s\",\"mode\":\"%s\",\"channels\":%d,\"block\":%d,\"samples\":%ld,"
+                "\"sample_rate\":%g,\"ns_per_sample\":%.3f,",
+                scenarioNames[scenario], modeNames[mode], channels, settings.block, settings.samples, settings.sampleRate,
+                elapsed.count() / samples);
+    if (BENCH_HAS_TSC) {
+        std::printf("\"cycles_per_sample\":%.3f,", cycles / samples);
+    } else {
+        std::printf("\"cycles_per_sample\":null,");
+    }
+    std::printf("\"regenerations\":%u,\"regenerations_per_second\":%.3f}\n",
+                regenerations, regenerations / audioSeconds);
+    std::fflush(stdout);
+}
+
+// Returns the number of mismatching bytes or masks between the SIMD and scalar bar kernels.
+long verifyBarKernels() {
+    long mismatches = 0;
+    const int numLevels = kNumParts * kStepsPerPattern;
+
+    for (int x = 0; x < 256; ++x) {
+        for (int y = 0; y < 256; ++y) {
+            const int i = x >> 6;
+            const int j = y >> 6;
+            uint8_t fast[numLevels];
+            uint8_t reference[numLevels];
+            mixDrumMapLevels(drum_map[i][j], drum_map[i + 1][j], drum_map[i][j + 1], drum_map[i + 1][j + 1],
+                             (uint8_t)(x << 2), (uint8_t)(y << 2), fast, numLevels);
+            mixDrumMapLevelsScalar(drum_map[i][j], drum_map[i + 1][j], drum_map[i][j + 1], drum_map[i + 1][j + 1],
+                                   (uint8_t)(x << 2), (uint8_t)(y << 2), reference, numLevels);
+            for (int k = 0; k < numLevels; ++k) {
+                mismatches += fast[k] != reference[k];
+            }
+        }
+    }
+
+    uint8_t levels[256];
+    for (int k = 0; k < 256; ++k) {
+        levels[k] = (uint8_t)k;
+    }
+    for (int perturbation = 0; perturbation < 256; ++perturbation) {
+        for (int threshold = 0; threshold < 256; ++threshold) {
+            for (int block = 0; block < 256; block += kBarKernelBlock) {
+                uint32_t triggers, accents, referenceTriggers, referenceAccents;
+                thresholdDrumLevels(levels + block, (uint8_t)perturbation, (uint8_t)threshold, &triggers, &accents);
+                thresholdDrumLevelsScalar(levels + block, (uint8_t)perturbation, (uint8_t)threshold,
+                                          &referenceTriggers, &referenceAccents);
+                mismatches += (triggers != referenceTriggers) + (accents != referenceAccents);
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Returns the number of frames where HCVPhasorResetDetector4 disagrees with four scalar detectors
+// fed the same lanes. The vectors are every ordered pair of edge-case inputs (zeros of either sign,
+// NaN, infinities, denormals, the ends of the range and values whose ratio lands exactly on the
+// threshold), steps of exactly the threshold ratio, held values for the repeat filter, and a fixed
+// pseudo-random stream, at several thresholds.
+long verifyResetDetectors() {
+    const float edgeCases[] = {0.f, -0.f, NAN, -NAN, INFINITY, -INFINITY, 1e-40f, -1e-40f, FLT_MIN, FLT_MAX,
+                               1.f, -1.f, 0.5f, 0.25f, 0.75f, 0.125f, 0.375f, 1.f / 3.f, 0.99999994f, 1e-7f};
+    const int numEdgeCases = sizeof(edgeCases) / sizeof(edgeCases[0]);
+    const float thresholds[] = {0.5f, 0.f, 1.f, 0.2f};
+
+    // Lane inputs, frame by frame
+    std::vector<float> lanes[4];
+    for (int a = 0; a < numEdgeCases; ++a) {
+        for (int b = 0; b < numEdgeCases; ++b) {
+            for (int k = 0; k < 4; ++k) {
+                // Each lane walks the pairs at its own offset, so lanes differ within a frame
+                const int pair = (a * numEdgeCases + b + k * 7) % (numEdgeCases * numEdgeCases);
+                lanes[k].push_back(edgeCases[pair / numEdgeCases]);
+                lanes[k].push_back(edgeCases[pair % numEdgeCases]);
+            }
+        }
+    }
+    // x -> 3x and back is a ratio of exactly 0.5 for powers of two
+    for (int e = -10; e <= 0; ++e) {
+        const float x = std::ldexp(1.f, e) * 0.25f;
+        const float steps[] = {x, 3.f * x, 3.f * x, x, x, 3.f * x};
+        for (float value : steps) {
+            for (int k = 0; k < 4; ++k) {
+                lanes[k].push_back(k & 1 ? -value : value);
+            }
+        }
+    }
+    uint32_t random = 12345;
+    for (int i = 0; i < 100000; ++i) {
+        for (int k = 0; k < 4; ++k) {
+            random = random * 1664525u + 1013904223u;
+            const float value = (random >> 8) * (1.f / 16777216.f) * 1.5f - 0.25f;
+            // Hold the last value now and then, and snap some values onto the 0..1 ends
+            if ((random & 7) == 0 && !lanes[k].empty()) {
+                lanes[k].push_back(lanes[k].back());
+            } else if ((random & 7) == 1) {
+                lanes[k].push_back((random & 8) ? 1.f : 0.f);
+            } else {
+                lanes[k].push_back(value);
+            }
+        }
+    }
+
+    long mismatches = 0;
+    for (float threshold : thresholds) {
+        HCVPhasorResetDetector scalar[4];
+        HCVPhasorResetDetector4 vector;
+        for (int k = 0; k < 4; ++k) {
+            scalar[k].setThreshold(threshold);
+        }
+        vector.setThreshold(threshold);
+
+        for (size_t i = 0; i < lanes[0].size(); ++i) {
+            int expected = 0;
+            for (int k = 0; k < 4; ++k) {
+                expected |= (int)scalar[k].detectProportionalReset(lanes[k][i]) << k;
+            }
+            const simd::float_4 frame(lanes[0][i], lanes[1][i], lanes[2][i], lanes[3][i]);
+            mismatches += vector.detectProportionalReset(frame) != expected;
+        }
+    }
+    return mismatches;
+}
+
+// Returns the number of scrubs whose crossing events are not where the phasor crossed the step
+// boundaries. Each scrub moves a freshly located phasor over several boundaries in one sample,
+// forwards and backwards, and has to report one event per boundary, in the order they were crossed,
+// with offsets that increase through the sample and match the boundaries' linear interpolation.
+// The analyzer's step offset has to be the last crossing's. Wraps through the bar start, which the
+// reset detector flags, have to report where they crossed as well.
+long verifyStepCrossings() {
+    const int stepCounts[] = {8, 16, 64};
+    long mismatches = 0;
+
+    for (int numberSteps : stepCounts) {
+        for (int direction = -1; direction <= 1; direction += 2) {
+            for (int crossed = 2; crossed <= HCVPhasorStepCrossings::maxEvents && 2 * crossed < numberSteps; ++crossed) {
+                for (int start = 0; start < numberSteps; ++start) {
+                    // Positions in steps, kept off the boundaries
+                    const float from = start + 0.3f;
+                    const float motion = direction * (crossed + 0.2f);
+                    const float to = from + motion;
+                    const float fromPhasor = from / numberSteps;
+                    const float toPhasor = std::fmod(to + numberSteps, (float)numberSteps) / numberSteps;
+
+                    HCVPhasorStepCrossings crossings;
+                    crossings.process(fromPhasor, numberSteps);
+                    const int numEvents = crossings.process(toPhasor, numberSteps);
+
+                    HCVPhasorAnalyzer analyzer;
+                    analyzer.setNumberSteps(numberSteps);
+                    analyzer.setCrossingMode(true);
+                    analyzer(fromPhasor, false);
+                    analyzer(toPhasor, false);
+
+                    bool matches = numEvents == crossed && analyzer.getStepChanged();
+                    float lastOffset = 0.f;
+                    for (int e = 0; matches && e < numEvents; ++e) {
+                        const HCVPhasorStepEvent& event = crossings.getEvent(e);
+                        // Forwards the boundaries are the starts of the steps entered, backwards their ends
+                        const int boundary = direction > 0 ? start + 1 + e : start - e;
+                        const int step = ((direction > 0 ? boundary : boundary - 1) + numberSteps) % numberSteps;
+                        const float expected = (boundary - from) / motion;
+                        matches = event.step == step && event.direction == direction && event.offset > lastOffset &&
+                                  std::fabs(event.offset - expected) < 1e-4f;
+                        lastOffset = event.offset;
+                    }
+                    matches = matches && std::fabs(analyzer.getStepOffset() - (1.f - lastOffset)) < 1e-6f;
+                    mismatches += !matches;
+                }
+            }
+        }
+
+        // A wrap is reported as a reset, and lands on the first step at the point it crossed the bar start
+        for (int tenths = 1; tenths < 10; ++tenths) {
+            const float from = numberSteps - tenths * 0.1f;
+            const float motion = 0.95f;
+            HCVPhasorStepCrossings crossings;
+            crossings.process(from / numberSteps, numberSteps);
+            const int numEvents = crossings.process((from + motion - numberSteps) / numberSteps, numberSteps, true);
+            const float expected = (numberSteps - from) / motion;
+            mismatches += numEvents != 1 || crossings.getEvent(0).step != 0 ||
+                          std::fabs(crossings.getEvent(0).offset - expected) > 1e-4f;
+        }
+    }
+    return mismatches;
+}
+
+// Returns the number of frames where processBlock() on blocks of frames gives different outputs
+// from process() one frame at a time. Both modules share a seed and a scheduler slot, and get two
+// channels of the same phasor, in every mode and with chaos off and on, in both trigger modes and at
+// block sizes that do and don't divide the control rate. Parameters stay put, as the block path only
+// reads them once per block.
+long verifyBlockProcessing() {
+    const int blockSizes[] = {1, 32, 37, 512};
+    const int frames = 24000;
+    const int barFrames = 2400;
+    const int channels = 2;
+    long mismatches = 0;
+
+    for (int mode = 0; mode < PhasorBeatMap::NUM_SEQUENCER_MODES; ++mode) {
+        for (int chaos = 0; chaos < 2; ++chaos) {
+            for (int crossings = 0; crossings < 2; ++crossings) {
+                for (int blockSize : blockSizes) {
+                    PhasorBeatMap single;
+                    PhasorBeatMap block;
+                    PhasorBeatMap* modules[2] = {&single, &block};
+                    for (PhasorBeatMap* module : modules) {
+                        setupModule(*module, chaos ? CHAOS_RESETS : STATIC_PARAMS, mode, channels);
+                        module->setStepTriggerMode(crossings ? PhasorBeatMap::STEP_CROSSINGS : PhasorBeatMap::STEP_CHANGES);
+                        module->setSeed(1234);
+                        module->schedulerTicket = single.schedulerTicket;
+                        for (int c = 0; c < HCV_MAX_POLYPHONY; ++c) {
+                            module->firstBarDelay[c] = single.firstBarDelay[c];
+                            module->pendingDelay[c] = single.pendingDelay[c];
+                        }
+                    }
+
+                    Module::ProcessArgs args;
+                    args.sampleRate = 48000.f;
+                    args.sampleTime = 1.f / args.sampleRate;
+                    args.frame = 0;
+
+                    // The same normalized phasor process() reads back from the input voltage
+                    std::vector<float> phasors(channels * frames);
+                    for (int i = 0; i < frames; ++i) {
+                        for (int c = 0; c < channels; ++c) {
+                            const float phasor = ((i + c * barFrames / 3) % barFrames) / (float)barFrames;
+                            phasors[c * frames + i] = phasor * 10.f / 10.f;
+                        }
+                    }
+
+                    // process() needs its first call to pick up the channel count and parameters
+                    std::vector<float> expected(PhasorBeatMap::NUM_OUTPUTS * channels * frames);
+                    for (int i = 0; i < frames; ++i) {
+                        for (int c = 0; c < channels; ++c) {
+                            single.inputs[PhasorBeatMap::PHASOR_INPUT].setVoltage(phasors[c * frames + i] * 10.f, c);
+                        }
+                        ++args.frame;
+                        single.process(args);
+                        for (int o = 0; o < PhasorBeatMap::NUM_OUTPUTS; ++o) {
+                            for (int c = 0; c < channels; ++c) {
+                                expected[(o * channels + c) * frames + i] = single.outputs[o].getVoltage(c);
+                            }
+                        }
+                    }
+
+                    block.numChannels = channels;
+                    std::vector<float> output(PhasorBeatMap::NUM_OUTPUTS * channels * frames);
+                    std::vector<uint32_t> resets(blockSize);
+                    for (int i = 0; i < frames; i += blockSize) {
+                        const int n = std::min(blockSize, frames - i);
+                        block.processControlRate();
+                        block.detectResets(&phasors[i], frames, n, resets.data());
+                        for (int c = 0; c < channels; ++c) {
+                            float* outs[PhasorBeatMap::NUM_OUTPUTS];
+                            for (int o = 0; o < PhasorBeatMap::NUM_OUTPUTS; ++o) {
+                                outs[o] = &output[(o * channels + c) * frames + i];
+                            }
+                            block.processBlock(&phasors[c * frames + i], resets.data(), n, outs, c);
+                        }
+                    }
+
+                    for (int i = 0; i < frames; ++i) {
+                        bool matches = true;
+                        for (int o = 0; o < PhasorBeatMap::NUM_OUTPUTS * channels; ++o) {
+                            matches = matches && output[o * frames + i] == expected[o * frames + i];
+                        }
+                        mismatches += !matches;
+                    }
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+bool parseArguments(int argc, char** argv, BenchSettings& settings) {
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--samples") && hasValue) {
+            settings.samples = std::max(1L, std::atol(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--rate") && hasValue) {
+            settings.sampleRate = std::max(1.f, (float)std::atof(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--bar-hz") && hasValue) {
+            settings.barHz = std::max(0.001f, (float)std::atof(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--channels") && hasValue) {
+            settings.channels = clamp(std::atoi(argv[++i]), 1, HCV_MAX_POLYPHONY);
+        } else if (!std::strcmp(argv[i], "--block") && hasValue) {
+            settings.block = clamp(std::atoi(argv[++i]), 0, 4096);
+        } else if (!std::strcmp(argv[i], "--check")) {
+            settings.checkOnly = true;
+        } else {
+            std::fprintf(stderr, "Usage: %s [--samples N] [--rate HZ] [--bar-hz HZ] [--channels N] [--block N] [--check]\n",
+                         argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchSettings settings;
+    if (!parseArguments(argc, argv, settings)) {
+        return 1;
+    }
+
+    // Stand-in for the engine: no audio thread, just a context the module can query.
+    contextSet(new Context);
+    APP->engine = new engine::Engine;
+    APP->engine->setSuggestedSampleRate(settings.sampleRate);
+
+    const long kernelMismatches = verifyBarKernels();
+    std::printf("{\"check\":\"bar_kernels\",\"mismatches\":%ld}\n", kernelMismatches);
+    const long resetMismatches = verifyResetDetectors();
+    std::printf("{\"check\":\"reset_detectors\",\"mismatches\":%ld}\n", resetMismatches);
+    const long crossingMismatches = verifyStepCrossings();
+    std::printf("{\"check\":\"step_crossings\",\"mismatches\":%ld}\n", crossingMismatches);
+    const long blockMismatches = verifyBlockProcessing();
+    std::printf("{\"check\":\"block_processing\",\"mismatches\":%ld}\n", blockMismatches);
+    if (kernelMismatches || resetMismatches || crossingMismatches || blockMismatches) {
+        return 1;
+    }
+    if (settings.checkOnly) {
+        return 0;
+    }
+
+    for (int scenario = 0; scenario < NUM_SCENARIOS; ++scenario) {
+        for (int mode = 0; mode < PhasorBeatMap::NUM_SEQUENCER_MODES; ++mode) {
+            runScenario(settings, (Scenario)scenario, mode);
+        }
+    }
+    return 0;
+}
@@ -1,5 +1,17 @@
 #include "HCVPhasorAnalyzers.h"
 
+static float estimateStepOffset(float _fractionalStep, float _stepSlope)
+{
+    //Distance travelled past the boundary this sample, divided by the distance travelled per sample.
+    //Forward motion crossed the start of the step, reverse motion crossed its end.
+    float distance = _stepSlope >= 0.0f ? _fractionalStep : 1.0f - _fractionalStep;
+    float speed = std::abs(_stepSlope);
+
+    //Jumps and stopped phasors have no meaningful crossing point, so they land on the sample itself.
+    if(speed <= distance) return 0.0f;
+    return distance / speed;
+}
+
 bool HCVPhasorResetDetector::detectProportionalReset(float _normalizedPhasorIn)
 {
     const float difference = _normalizedPhasorIn - lastSample;
@@ -15,16 +27,113 @@ bool HCVPhasorResetDetector::detectProportionalReset(float _normalizedPhasorIn)
     return repeatFilter.process(resetDetected);
 }
 
+int HCVPhasorResetDetector4::detectProportionalReset(rack::simd::float_4 _normalizedPhasorsIn)
+{
+    using rack::simd::float_4;
+
+    const float_4 difference = _normalizedPhasorsIn - lastSample;
+    const float_4 sum = _normalizedPhasorsIn + lastSample;
+    lastSample = _normalizedPhasorsIn;
+
+    //Lanes with a zero sum skip the repeat filter, like the scalar early return
+    const float_4 active = sum != 0.0f;
+    const float_4 resetDetected = rack::simd::fabs(difference / sum) > threshold;
+
+    const float_4 rising = active & resetDetected & ~repeatState;
+    repeatState = rack::simd::ifelse(active, resetDetected, repeatState);
+    return rack::simd::movemask(rising);
+}
+
+int HCVPhasorStepCrossings::process(float _normalizedPhasorIn, int _numberSteps, bool _reset)
+{
+    numEvents = 0;
+    const float position = _normalizedPhasorIn * _numberSteps;
+
+    //Motion since the last sample, the short way round the bar so wrapping counts as moving on
+    const float halfBar = _numberSteps * 0.5f;
+    float motion = position - lastPosition;
+    if(motion >= halfBar) motion -= _numberSteps;
+    else if(motion < -halfBar) motion += _numberSteps;
+    lastPosition = position;
+
+    //A reset jumps straight to the step it lands on, whatever lies in between
+    const bool jumped = _reset && located && _numberSteps == numberSteps && std::isfinite(motion);
+    if(!located || _reset || _numberSteps != numberSteps || !std::isfinite(motion))
+    {
+        const int lastStep = currentStep;
+        numberSteps = _numberSteps;
+        currentStep = clamp((int)floorf(position), 0, numberSteps - 1);
+        stepPosition = position - currentStep;
+        entryDirection = 0;
+        located = std::isfinite(position);
+        if(jumped && located && currentStep != lastStep)
+        {
+            HCVPhasorStepEvent& event = events[numEvents++];
+            event.step = currentStep;
+            event.direction = motion < 0.0f ? -1 : 1;
+            //A wrap or a one-step reset still crossed the start of the step, as far as the slope can tell
+            event.offset = 1.0f - estimateStepOffset(stepPosition, motion);
+        }
+        return numEvents;
+    }
+    stepPosition += motion;
+
+    const float lowMargin = entryDirection > 0 ? hysteresis : 0.0f;
+    const float highMargin = entryDirection < 0 ? hysteresis : 0.0f;
+    int direction = 0;
+    int crossed = 0;
+    if(stepPosition >= 1.0f + highMargin)
+    {
+        direction = 1;
+        crossed = (int)floorf(stepPosition);
+    }
+    else if(stepPosition < -lowMargin)
+    {
+        direction = -1;
+        crossed = (int)ceilf(-stepPosition);
+    }
+    if(crossed == 0) return 0;
+
+    const int firstReported = crossed > maxEvents ? crossed - maxEvents : 0;
+    for(int i = firstReported; i < crossed; ++i)
+    {
+        //Boundary i + 1 steps ahead of the step's start going forward, i steps behind it in reverse,
+        //as a share of the motion from the previous sample's position
+        const float boundary = direction > 0 ? (float)(i + 1) : (float)(-i);
+        HCVPhasorStepEvent& event = events[numEvents++];
+        event.step = ((currentStep + direction * (i + 1)) % numberSteps + numberSteps) % numberSteps;
+        event.direction = direction;
+        event.offset = clamp((boundary - (stepPosition - motion)) / motion, 0.0f, 1.0f);
+    }
+
+    currentStep = ((currentStep + direction * crossed) % numberSteps + numberSteps) % numberSteps;
+    stepPosition -= (float)(direction * crossed);
+    entryDirection = direction;
+    return numEvents;
+}
+
 bool HCVPhasorStepDetector::operator()(float _normalizedPhasorIn)
 {
     float scaledPhasor = _normalizedPhasorIn * numberSteps;
     int incomingStep = floorf(scaledPhasor);
     fractionalStep = scaledPhasor - incomingStep;
+    float stepSlope = slopeDetector.calculateSteadySlope(_normalizedPhasorIn) * numberSteps;
+
+    if(crossingMode)
+    {
+        const bool reset = resetDetector.detectProportionalReset(_normalizedPhasorIn);
+        const int numEvents = crossings.process(_normalizedPhasorIn, numberSteps, reset);
+        currentStep = crossings.getCurrentStep();
+        stepChanged = numEvents > 0;
+        if(stepChanged) stepOffset = 1.0f - crossings.getEvent(numEvents - 1).offset;
+        return stepChanged;
+    }
 
     if(numberSteps == 1)
     {
         currentStep = 0;
         stepChanged = resetDetector.detectSimpleReset(_normalizedPhasorIn);
+        if(stepChanged) stepOffset = calculateStepOffset(stepSlope);
         return stepChanged;
     }
 
@@ -32,6 +141,7 @@ bool HCVPhasorStepDetector::operator()(float _normalizedPhasorIn)
     {
         currentStep = incomingStep;
         stepChanged = true;
+        stepOffset = calculateStepOffset(stepSlope);
         return stepChanged;
     }
 
@@ -39,6 +149,64 @@ bool HCVPhasorStepDetector::operator()(float _normalizedPhasorIn)
     return stepChanged;
 }
 
+float HCVPhasorStepDetector::calculateStepOffset(float _stepSlope)
+{
+    return estimateStepOffset(fractionalStep, _stepSlope);
+}
+
+void HCVPhasorAnalyzer::operator()(float _normalizedPhasorIn)
+{
+    //Proportional reset, as HCVPhasorResetDetector::detectProportionalReset
+    bool reset = false;
+    const float sum = _normalizedPhasorIn + lastSample;
+    if(sum != 0.0f)
+    {
+        const float proportionalChange = std::abs((_normalizedPhasorIn - lastSample)/sum);
+        reset = repeatFilter.process(proportionalChange > resetThreshold);
+    }
+
+    operator()(_normalizedPhasorIn, reset);
+}
+
+void HCVPhasorAnalyzer::operator()(float _normalizedPhasorIn, bool _resetDetected)
+{
+    const float rawSlope = _normalizedPhasorIn - lastSample;
+    lastSample = _normalizedPhasorIn;
+    slope = gam::scl::wrap(rawSlope, 0.5f, -0.5f);
+    if(slope != 0.0f) reversePhasor = slope < 0.0f;
+    resetDetected = _resetDetected;
+
+    const float scaledPhasor = _normalizedPhasorIn * numberSteps;
+    const int incomingStep = floorf(scaledPhasor);
+    fractionalStep = scaledPhasor - incomingStep;
+
+    if(crossingMode)
+    {
+        const int numEvents = crossings.process(_normalizedPhasorIn, numberSteps, resetDetected);
+        currentStep = crossings.getCurrentStep();
+        stepChanged = numEvents > 0;
+        if(stepChanged) stepOffset = 1.0f - crossings.getEvent(numEvents - 1).offset;
+    }
+    else
+    {
+        //A single step only changes when the phasor jumps, as HCVPhasorResetDetector::detectSimpleReset
+        if(numberSteps == 1)
+        {
+            currentStep = 0;
+            stepChanged = std::abs(rawSlope) >= 0.5f;
+        }
+        else
+        {
+            stepChanged = incomingStep != currentStep;
+            currentStep = incomingStep;
+        }
+        if(stepChanged) stepOffset = estimateStepOffset(fractionalStep, slope * numberSteps);
+    }
+
+    const float gatePosition = smartGate && reversePhasor ? 1.0f - fractionalStep : fractionalStep;
+    gate = gatePosition < gateWidth;
+}
+
 float HCVPhasorGateDetector::getSmartGate(float normalizedPhasor)
 {
     //only change reverse direction detection if phasor is moving, otherwise high frequency noise will result ;)
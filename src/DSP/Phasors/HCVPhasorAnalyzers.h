@@ -5,6 +5,7 @@
 #include "Gamma/Domain.h"
 #include "Gamma/scl.h"
 #include "dsp/digital.hpp"
+#include "simd/functions.hpp"
 
 class HCVPhasorSlopeDetector
 {
@@ -81,28 +82,169 @@ private:
     rack::dsp::BooleanTrigger repeatFilter;
 };
 
+//Four HCVPhasorResetDetector::detectProportionalReset lanes, one phasor per lane.
+//Matches the scalar detector bit for bit: the ratio is an exact vector divide, since a reciprocal
+//estimate would move results that land on the threshold, and the repeat filter is a lane mask.
+class HCVPhasorResetDetector4
+{
+public:
+    //Returns bit i set when lane i sees a new reset
+    int operator()(rack::simd::float_4 _normalizedPhasorsIn)
+    {
+        return detectProportionalReset(_normalizedPhasorsIn);
+    }
+
+    int detectProportionalReset(rack::simd::float_4 _normalizedPhasorsIn);
+
+    void setThreshold(float _threshold)
+    {
+        threshold = clamp(_threshold, 0.0f, 1.0f);
+    }
+
+private:
+    rack::simd::float_4 lastSample = 0.0f;
+    rack::simd::float_4 threshold = 0.5f;
+    rack::simd::float_4 repeatState = rack::simd::float_4::mask(); //BooleanTrigger starts high
+};
+
+//A step boundary crossed during the last sample
+struct HCVPhasorStepEvent
+{
+    int step;        //step entered
+    int direction;   //1 forward, -1 reverse
+    float offset;    //where the boundary lies within the last sample interval: 0 at the previous
+                     //sample, 1 at this one, so the events of a sample come in increasing order
+};
+
+//Every step boundary a phasor crosses, in order and in either direction, so scrubs and jumps play
+//each step they pass. The boundary a step was entered through has to be passed by an extra
+//hysteresis (in steps) before it counts again, so a phasor jittering on a boundary doesn't
+//retrigger, while steps entered in the direction of travel fire right away. A phasor reset is a
+//jump rather than a scrub: it relocates, and the step it lands on is the only event.
+class HCVPhasorStepCrossings
+{
+public:
+    //At most this many events per sample. Longer jumps report the crossings nearest their end.
+    static constexpr int maxEvents = 8;
+
+    //Returns the number of events for this sample. The first sample only locates the phasor.
+    int process(float _normalizedPhasorIn, int _numberSteps, bool _reset = false);
+
+    void setHysteresis(float _steps){hysteresis = clamp(_steps, 0.0f, 0.5f);}
+    void relocate(){located = false;}
+
+    int getCurrentStep(){return currentStep;}
+    int getNumEvents(){return numEvents;}
+    const HCVPhasorStepEvent& getEvent(int _index){return events[_index];}
+
+private:
+    HCVPhasorStepEvent events[maxEvents];
+    int numEvents = 0;
+
+    bool located = false;
+    int numberSteps = 1;
+    int currentStep = 0;
+    int entryDirection = 0;
+    float lastPosition = 0.0f;
+    float stepPosition = 0.0f; //position in steps from the start of currentStep, unwrapped
+    float hysteresis = 0.05f;
+};
+
 class HCVPhasorStepDetector
 {
 public:
 
     bool operator()(float _normalizedPhasorIn);
 
+    //Crossing mode reports every step crossed (see HCVPhasorStepCrossings) instead of step index
+    //changes. currentStep then follows the crossings, and stepOffset is the last crossing's,
+    //1 - offset samples before this sample.
+    void setCrossingMode(bool _crossingModeEnabled){crossingMode = _crossingModeEnabled; crossings.relocate();}
+    HCVPhasorStepCrossings& getStepCrossings(){return crossings;}
+
     int getCurrentStep(){return currentStep;}
     void setNumberSteps(int _numSteps){numberSteps = std::max(1, _numSteps);}
     float getFractionalStep(){return fractionalStep;}
     bool getStepChangedThisSample() {return stepChanged;}
     bool getIsPlaying() {return isPlaying;}
 
+    //How far the step boundary lies before this sample, in samples (0 to 1).
+    //Estimated from the phasor slope, so only meaningful when getStepChangedThisSample() is true.
+    float getStepOffset() {return stepOffset;}
+
 protected:
+    float calculateStepOffset(float _stepSlope);
+
     int currentStep = 0;
     int numberSteps = 1;
     bool stepChanged = false;
     bool isPlaying = false;
     float fractionalStep = 0.0f;
+    float stepOffset = 0.0f;
+    bool crossingMode = false;
+    HCVPhasorStepCrossings crossings;
     HCVPhasorResetDetector resetDetector;
     HCVPhasorSlopeDetector slopeDetector;
 };
 
+//One pass over a phasor for everything the detectors above work out on their own: slope, direction,
+//proportional reset, step, fractional step and step gate. They all come from a single difference
+//per sample, and the results describe the last sample processed until the next one.
+class HCVPhasorAnalyzer
+{
+public:
+    void operator()(float _normalizedPhasorIn);
+
+    //Same, with the reset already detected elsewhere, e.g. four channels at a time by HCVPhasorResetDetector4
+    void operator()(float _normalizedPhasorIn, bool _resetDetected);
+
+    void setNumberSteps(int _numSteps){numberSteps = std::max(1, _numSteps);}
+    void setResetThreshold(float _threshold){resetThreshold = clamp(_threshold, 0.0f, 1.0f);}
+    void setGateWidth(float _width){gateWidth = _width;}
+
+    //In smart mode the gate opens at the end of each step while the phasor runs backwards
+    void setSmartGate(bool _smartGateEnabled){smartGate = _smartGateEnabled;}
+
+    //As HCVPhasorStepDetector::setCrossingMode
+    void setCrossingMode(bool _crossingModeEnabled){crossingMode = _crossingModeEnabled; crossings.relocate();}
+    HCVPhasorStepCrossings& getStepCrossings(){return crossings;}
+
+    //Wrapped slope, as HCVPhasorSlopeDetector::calculateSteadySlope
+    float getSlope(){return slope;}
+    float getSlopeDirection(){return slope > 0.0f ? 1.0f : (slope < 0.0f ? -1.0f : 0.0f);}
+    bool getReset(){return resetDetected;}
+    int getCurrentStep(){return currentStep;}
+    float getFractionalStep(){return fractionalStep;}
+    bool getStepChanged(){return stepChanged;}
+    bool getGate(){return gate;}
+
+    //How far the step boundary lies before this sample, in samples (0 to 1).
+    //Only meaningful when getStepChanged() is true.
+    float getStepOffset(){return stepOffset;}
+
+private:
+    float lastSample = 0.0f;
+    float slope = 0.0f;
+    bool reversePhasor = false;
+
+    float resetThreshold = 0.5f;
+    bool resetDetected = false;
+    rack::dsp::BooleanTrigger repeatFilter;
+
+    int numberSteps = 1;
+    int currentStep = 0;
+    float fractionalStep = 0.0f;
+    bool stepChanged = false;
+    float stepOffset = 0.0f;
+
+    float gateWidth = 0.5f;
+    bool smartGate = false;
+    bool gate = false;
+
+    bool crossingMode = false;
+    HCVPhasorStepCrossings crossings;
+};
+
 class HCVPhasorGateDetector
 {
 public:
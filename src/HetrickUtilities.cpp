@@ -55,6 +55,19 @@ void PanelBaseWidget::draw(const DrawArgs& args) {
 	TransparentWidget::draw(args);
 }
 
+HCVThemedRoganSvgs::HCVThemedRoganSvgs() {
+	bg = Svg::load(asset::system("res/ComponentLibrary/Rogan1P_bg.svg"));
+	lightBase = Svg::load(asset::system("res/ComponentLibrary/Rogan1PRed.svg"));
+	darkBase = Svg::load(asset::system("res/ComponentLibrary/Rogan1PBlue.svg"));
+	lightFG = Svg::load(asset::system("res/ComponentLibrary/Rogan1PRed_fg.svg"));
+	darkFG = Svg::load(asset::system("res/ComponentLibrary/Rogan1PBlue_fg.svg"));
+}
+
+const HCVThemedRoganSvgs& HCVThemedRoganSvgs::get() {
+	static const HCVThemedRoganSvgs svgs;
+	return svgs;
+}
+
 void InverterWidget::refreshForTheme() {
 	int newMode = settings::preferDarkPanels ? 1 : 0;
 	if (newMode != oldMode) {
@@ -161,23 +161,39 @@ struct InverterWidget : TransparentWidget {
 	void draw(const DrawArgs& args) override;
 };
 
+// Rack's Rogan1P SVGs for both themes, loaded once and shared by every HCVThemedRogan
+struct HCVThemedRoganSvgs
+{
+    std::shared_ptr<window::Svg> bg;
+    std::shared_ptr<window::Svg> lightBase;
+    std::shared_ptr<window::Svg> darkBase;
+    std::shared_ptr<window::Svg> lightFG;
+    std::shared_ptr<window::Svg> darkFG;
+
+    HCVThemedRoganSvgs();
+    static const HCVThemedRoganSvgs& get();
+};
+
 struct HCVThemedRogan : rack::Rogan
 {
-    std::shared_ptr<window::Svg> lightBase = Svg::load(asset::system("res/ComponentLibrary/Rogan1PRed.svg"));
-    std::shared_ptr<window::Svg> darkBase = Svg::load(asset::system("res/ComponentLibrary/Rogan1PBlue.svg"));
-    std::shared_ptr<window::Svg> lightFG = Svg::load(asset::system("res/ComponentLibrary/Rogan1PRed_fg.svg"));
-    std::shared_ptr<window::Svg> darkFG = Svg::load(asset::system("res/ComponentLibrary/Rogan1PBlue_fg.svg"));
+    int themeMode = -1;
 
     HCVThemedRogan()
     {
-        bg->setSvg(Svg::load(asset::system("res/ComponentLibrary/Rogan1P_bg.svg")));
+        bg->setSvg(HCVThemedRoganSvgs::get().bg);
         setThemedSVGs();
     }
 
+    // Setting an SVG redraws the knob's framebuffer, so only do it when the theme flips
     void setThemedSVGs()
     {
-        setSvg(settings::preferDarkPanels ? darkBase : lightBase);
-        fg->setSvg(settings::preferDarkPanels ? darkFG : lightFG);
+        int newMode = settings::preferDarkPanels ? 1 : 0;
+        if (newMode == themeMode) return;
+        themeMode = newMode;
+
+        const HCVThemedRoganSvgs& svgs = HCVThemedRoganSvgs::get();
+        setSvg(newMode ? svgs.darkBase : svgs.lightBase);
+        fg->setSvg(newMode ? svgs.darkFG : svgs.lightFG);
     }
 
     void step() override
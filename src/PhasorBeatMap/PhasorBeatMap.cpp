@@ -7,6 +7,10 @@
 
 #include "PhasorBeatMap.hpp"
 
+const int PhasorBeatMap::kControlRateDivisions[PhasorBeatMap::kNumControlRates] = {1, 8, 32, 128};
+const int PhasorBeatMap::kBarLengths[PhasorBeatMap::kNumBarLengths] = {8, 12, 16, 24, 32, 48, 64};
+const int PhasorBeatMap::kStepsPerUpdate;
+
 PhasorBeatMap::PhasorBeatMap() {
 	config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
 
@@ -40,26 +44,38 @@ PhasorBeatMap::PhasorBeatMap() {
     configOutput(PhasorBeatMap::HH_ACC_OUTPUT, "Channel 3 Accent");
 
     // Initialize
-    srand(time(NULL));
-    stepDetector.setNumberSteps(32);
-
-    for (int i = 0; i < 6; ++i) {
-        drumTriggers[i] = Oneshot(0.001, APP->engine->getSampleRate());
-    }
-    for (int i = 0; i < 3; ++i) {
-        drumLED[i] = Oneshot(0.1, APP->engine->getSampleRate());
+    schedulerTicket = BarScheduler::takeTicket();
+    for (int c = 0; c < HCV_MAX_POLYPHONY; ++c) {
+        barCache[c] = &barBuffers[0][c];
+        pendingBar[c] = &barBuffers[1][c];
+        pendingStage[c] = 0;
+        pendingReady[c] = false;
+        phasorAnalyzer[c].setNumberSteps(kStepsPerPattern);
+        lastStep[c] = -1;
+        phasorLocated[c] = false;
+        firstBarDelay[c] = BarScheduler::slotDelay(schedulerTicket, c);
+        pendingDelay[c] = firstBarDelay[c];
+        channelMode[c] = ORIGINAL;
     }
+    setSeed(patternGenerator.getSeed());
+    setPulseSampleRate(APP->engine->getSampleRate());
     panelStyle = 0;
+    setControlRateDivision(controlRateDivision);
+    displayDivider.setDivision(256);
 
     // Set default pattern mode to Original
-    patternGenerator.setPatternMode(PATTERN_ORIGINAL);
+    patternGenerator.setPatternMode(toPatternMode(ORIGINAL));
 }
 
 json_t* PhasorBeatMap::dataToJson() {
     json_t *rootJ = json_object();
     json_object_set_new(rootJ, "sequencerMode", json_integer(sequencerMode));
+    json_object_set_new(rootJ, "seed", json_integer(patternGenerator.getSeed()));
     json_object_set_new(rootJ, "triggerOutputMode", json_integer(triggerOutputMode));
     json_object_set_new(rootJ, "panelStyle", json_integer(panelStyle));
+    json_object_set_new(rootJ, "controlRateDivision", json_integer(controlRateDivision));
+    json_object_set_new(rootJ, "barLength", json_integer(barLength));
+    json_object_set_new(rootJ, "stepTriggerMode", json_integer(stepTriggerMode));
     return rootJ;
 }
 
@@ -85,6 +101,14 @@ void PhasorBeatMap::dataFromJson(json_t* rootJ) {
         }
     }
 
+    json_t* seedJ = json_object_get(rootJ, "seed");
+    if (seedJ) {
+        setSeed((uint32_t)json_integer_value(seedJ));
+        for (int c = 0; c < HCV_MAX_POLYPHONY; ++c) {
+            requestRegeneration(c);
+        }
+    }
+
     json_t* triggerOutputModeJ = json_object_get(rootJ, "triggerOutputMode");
 	if (triggerOutputModeJ) {
 		triggerOutputMode = (PhasorBeatMap::TriggerOutputMode) json_integer_value(triggerOutputModeJ);
@@ -94,148 +118,508 @@ void PhasorBeatMap::dataFromJson(json_t* rootJ) {
     if (panelStyleJ) {
         panelStyle = (int)json_integer_value(panelStyleJ);
     }
+
+    json_t* controlRateDivisionJ = json_object_get(rootJ, "controlRateDivision");
+    if (controlRateDivisionJ) {
+        setControlRateDivision((int)json_integer_value(controlRateDivisionJ));
+    }
+
+    json_t* barLengthJ = json_object_get(rootJ, "barLength");
+    if (barLengthJ) {
+        setBarLength((int)json_integer_value(barLengthJ));
+    }
+
+    json_t* stepTriggerModeJ = json_object_get(rootJ, "stepTriggerMode");
+    if (stepTriggerModeJ) {
+        setStepTriggerMode((StepTriggerMode)json_integer_value(stepTriggerModeJ));
+    }
+    parametersDirty = true;
 }
 
 void PhasorBeatMap::process(const ProcessArgs &args) {
-    // Read mode parameter with CV
-    float modeValue = params[MODE_PARAM].getValue();
-    if (inputs[MODE_CV].isConnected()) {
-        modeValue += inputs[MODE_CV].getVoltage() * 0.4f;  // 2.5V per mode step
+    // Every input is polyphonic; each channel runs its own phasor, pattern and triggers
+    numChannels = setupPolyphonyForAllOutputs();
+
+    // Parameters and regeneration checks run at control rate; step detection stays at audio rate
+    if (controlDivider.process() || numChannels != lastNumChannels) {
+        processControlRate();
     }
-    int modeIndex = clamp((int)round(modeValue), 0, (int)NUM_SEQUENCER_MODES - 1);
 
-    // Update sequencer mode if changed
-    if (modeIndex != (int)sequencerMode) {
-        sequencerMode = (SequencerMode)modeIndex;
+    // Rack hands us one frame at a time, so each channel runs the block core for n = 1
+    float phasors[HCV_MAX_POLYPHONY];
+    for (int c = 0; c < numChannels; ++c) {
+        phasors[c] = inputs[PHASOR_INPUT].getPolyVoltage(c) / 10.0f;  // Normalize to 0-1
+    }
+    uint32_t resets = 0;
+    detectResets(phasors, 1, 1, &resets);
 
-        switch (sequencerMode) {
-            case ORIGINAL:
-                patternGenerator.setPatternMode(PATTERN_ORIGINAL);
-                inEuclideanMode = 0;
-                break;
-            case HENRI:
-                patternGenerator.setPatternMode(PATTERN_HENRI);
-                inEuclideanMode = 0;
-                break;
-            case EUCLIDEAN:
-                patternGenerator.setPatternMode(PATTERN_EUCLIDEAN);
-                inEuclideanMode = 1;
-                break;
-            default:
-                break;
+    for (int c = 0; c < numChannels; ++c) {
+        float frame[6];
+        float* outs[6] = {&frame[0], &frame[1], &frame[2], &frame[3], &frame[4], &frame[5]};
+        processBlock(&phasors[c], &resets, 1, outs, c);
+
+        for (int i = 0; i < 6; ++i) {
+            outputs[outIDs[i]].setVoltage(frame[i], c);
         }
-        barCache.needsRegeneration = true;
-    }
-
-    // Read pattern parameters
-    mapX = clamp(params[MAPX_PARAM].getValue() + inputs[MAPX_CV].getVoltage() / 10.f, 0.f, 1.f);
-    mapY = clamp(params[MAPY_PARAM].getValue() + inputs[MAPY_CV].getVoltage() / 10.f, 0.f, 1.f);
-    chaos = clamp(params[CHAOS_PARAM].getValue() + inputs[CHAOS_CV].getVoltage() / 10.f, 0.f, 1.f);
-    BDFill = clamp(params[BD_DENS_PARAM].getValue() + inputs[BD_FILL_CV].getVoltage() / 10.f, 0.f, 1.f);
-    SNFill = clamp(params[SN_DENS_PARAM].getValue() + inputs[SN_FILL_CV].getVoltage() / 10.f, 0.f, 1.f);
-    HHFill = clamp(params[HH_DENS_PARAM].getValue() + inputs[HH_FILL_CV].getVoltage() / 10.f, 0.f, 1.f);
-
-    // Set pattern generator parameters
-    patternGenerator.setMapX(mapX);
-    patternGenerator.setMapY(mapY);
-    patternGenerator.setBDDensity(BDFill);
-    patternGenerator.setSDDensity(SNFill);
-    patternGenerator.setHHDensity(HHFill);
-    patternGenerator.setRandomness(chaos);
-    patternGenerator.setEuclideanLength(0, mapX);
-    patternGenerator.setEuclideanLength(1, mapY);
-    patternGenerator.setEuclideanLength(2, chaos);
-
-    // Check if bar needs regeneration due to parameter changes
-    if (checkBarRegenerationNeeded()) {
-        patternGenerator.generateBar(barCache);
-    }
-
-    // Process phasor input
-    float phasor = inputs[PHASOR_INPUT].getVoltage() / 10.0f;  // Normalize to 0-1
-    phasor = clamp(phasor, 0.f, 1.f);
-
-    // Detect phasor resets and regenerate bar if chaos is active
-    if (resetDetector.detectProportionalReset(phasor)) {
-        if (chaos > 0.0f && !freezeActive) {
-            patternGenerator.generateBar(barCache);
+    }
+
+    // Update UI
+    updateUI();
+    if (displayDivider.process()) {
+        publishDisplaySnapshot();
+    }
+}
+
+// Snaps to the nearest of kControlRateDivisions, so a value from an edited patch still shows in the menu
+void PhasorBeatMap::setControlRateDivision(int division) {
+    controlRateDivision = kControlRateDivisions[0];
+    for (int i = 1; i < kNumControlRates; ++i) {
+        if (std::abs(kControlRateDivisions[i] - division) < std::abs(controlRateDivision - division)) {
+            controlRateDivision = kControlRateDivisions[i];
+        }
+    }
+    controlDivider.setDivision(controlRateDivision);
+}
+
+void PhasorBeatMap::setBarLength(int length) {
+    barLength = clamp(length, 1, (int)kMaxStepsPerPattern);
+    parametersDirty = true;
+}
+
+void PhasorBeatMap::setStepTriggerMode(StepTriggerMode mode) {
+    stepTriggerMode = mode == STEP_CROSSINGS ? STEP_CROSSINGS : STEP_CHANGES;
+    parametersDirty = true;
+}
+
+void PhasorBeatMap::processControlRate() {
+    const uint32_t connected = getConnectedCVInputs();
+    const bool paramsChanged = checkParamsChanged();
+
+    // With no CV patched the channel parameters only change when a param does
+    if (!parametersDirty && !paramsChanged && connected == 0 && connectedCVInputs == 0
+        && numChannels == lastNumChannels && barLength == activeBarLength
+        && stepTriggerMode == activeStepTriggerMode) {
+        return;
+    }
+    parametersDirty = false;
+    connectedCVInputs = connected;
+    lastNumChannels = numChannels;
+
+    // A new bar length changes what every step means, so all bars are drawn again
+    if (barLength != activeBarLength) {
+        activeBarLength = barLength;
+        for (int c = 0; c < HCV_MAX_POLYPHONY; ++c) {
+            phasorAnalyzer[c].setNumberSteps(activeBarLength);
+            requestRegeneration(c);
+        }
+    }
+    if (stepTriggerMode != activeStepTriggerMode) {
+        activeStepTriggerMode = stepTriggerMode;
+        for (int c = 0; c < HCV_MAX_POLYPHONY; ++c) {
+            phasorAnalyzer[c].setCrossingMode(activeStepTriggerMode == STEP_CROSSINGS);
         }
     }
 
-    // Feed to step detector
-    stepDetector(phasor);
+    readChannelParameters();
 
-    // Check for step changes
-    if (stepDetector.getStepChangedThisSample()) {
-        int currentStep = stepDetector.getCurrentStep();
-        triggerStepOutputs(currentStep);
-        lastStep = currentStep;
+    // Parameter changes keep the bar's chaos draw, so a density or chaos move only re-thresholds
+    // the cached levels. Euclidean bars are rebuilt a few steps per sample from here on (see
+    // processBlock), drum bars at once, and a pending bar that is still being built starts over, as
+    // its parts share one set of settings.
+    for (int c = 0; c < numChannels; ++c) {
+        if (!barCache[c]->needsRegeneration && checkBarSettingsChanged(c, *barCache[c])) {
+            updateBarSteps(c, *barCache[c], getPlayheadStep(c));
+        }
+        if (pendingReady[c] && checkBarSettingsChanged(c, *pendingBar[c])) {
+            updateBarSteps(c, *pendingBar[c], 0);
+        } else if (pendingStage[c] > 0 && checkBarSettingsChanged(c, *pendingBar[c])) {
+            pendingStage[c] = 0;
+        }
     }
+}
 
-    // Update trigger/gate outputs
-    if (triggerOutputMode == GATE) {
-        // Gate mode: output high for first 50% of step if trigger is active
-        int currentStep = stepDetector.getCurrentStep();
-        float fractionalStep = stepDetector.getFractionalStep();
-        const BarCache::StepData& data = barCache.steps[currentStep];
+// Bit i is set when CV input MAPX_CV + i is patched
+uint32_t PhasorBeatMap::getConnectedCVInputs() {
+    uint32_t connected = 0;
+    for (int i = MAPX_CV; i <= MODE_CV; ++i) {
+        connected |= (uint32_t)inputs[i].isConnected() << (i - MAPX_CV);
+    }
+    return connected;
+}
 
-        for (int i = 0; i < 3; ++i) {
-            bool gateHigh = data.trigger[i] && (fractionalStep < 0.5f);
-            outputs[outIDs[i]].setVoltage(gateHigh ? 10.0f : 0.0f);
+bool PhasorBeatMap::checkParamsChanged() {
+    bool changed = false;
+    for (int i = 0; i < NUM_PARAMS; ++i) {
+        const float value = params[i].getValue();
+        changed |= value != lastParamValues[i];
+        lastParamValues[i] = value;
+    }
+    return changed;
+}
+
+// Read pattern parameters for every channel, four channels at a time
+void PhasorBeatMap::readChannelParameters() {
+    const float mapXParam = params[MAPX_PARAM].getValue();
+    const float mapYParam = params[MAPY_PARAM].getValue();
+    const float chaosParam = params[CHAOS_PARAM].getValue();
+    const float BDParam = params[BD_DENS_PARAM].getValue();
+    const float SNParam = params[SN_DENS_PARAM].getValue();
+    const float HHParam = params[HH_DENS_PARAM].getValue();
+    const float modeParam = params[MODE_PARAM].getValue();
+
+    for (int c = 0; c < numChannels; c += 4) {
+        simd::clamp(mapXParam + inputs[MAPX_CV].getPolyVoltageSimd<simd::float_4>(c) / 10.f, 0.f, 1.f).store(&mapX[c]);
+        simd::clamp(mapYParam + inputs[MAPY_CV].getPolyVoltageSimd<simd::float_4>(c) / 10.f, 0.f, 1.f).store(&mapY[c]);
+        simd::clamp(chaosParam + inputs[CHAOS_CV].getPolyVoltageSimd<simd::float_4>(c) / 10.f, 0.f, 1.f).store(&chaos[c]);
+        simd::clamp(BDParam + inputs[BD_FILL_CV].getPolyVoltageSimd<simd::float_4>(c) / 10.f, 0.f, 1.f).store(&BDFill[c]);
+        simd::clamp(SNParam + inputs[SN_FILL_CV].getPolyVoltageSimd<simd::float_4>(c) / 10.f, 0.f, 1.f).store(&SNFill[c]);
+        simd::clamp(HHParam + inputs[HH_FILL_CV].getPolyVoltageSimd<simd::float_4>(c) / 10.f, 0.f, 1.f).store(&HHFill[c]);
+    }
 
-            // Accent outputs
-            bool accentGateHigh = data.trigger[i] && data.accent[i] && (fractionalStep < 0.5f);
-            outputs[outIDs[i + 3]].setVoltage(accentGateHigh ? 10.0f : 0.0f);
+    // Read mode parameter with CV
+    for (int c = 0; c < numChannels; ++c) {
+        float modeValue = modeParam;
+        if (inputs[MODE_CV].isConnected()) {
+            modeValue += inputs[MODE_CV].getPolyVoltage(c) * 0.4f;  // 2.5V per mode step
         }
-    } else {
-        // Pulse mode: use trigger generators
-        for (int i = 0; i < 6; ++i) {
-            drumTriggers[i].process();
-            outputs[outIDs[i]].setVoltage(drumTriggers[i].getState() ? 10.0f : 0.0f);
+        int modeIndex = clamp((int)round(modeValue), 0, (int)NUM_SEQUENCER_MODES - 1);
+
+        // Update sequencer mode if changed
+        if (modeIndex != (int)channelMode[c]) {
+            channelMode[c] = (SequencerMode)modeIndex;
+            requestRegeneration(c);
         }
     }
 
-    // Update UI
-    updateUI();
+    sequencerMode = channelMode[0];
+    inEuclideanMode = sequencerMode == EUCLIDEAN ? 1 : 0;
+}
+
+// Phasor resets of every channel over n frames, four channels at a time. Channel c's phasor for
+// frame i is phasor[c * stride + i]; bit c of resets[i] is set when channel c resets on frame i.
+void PhasorBeatMap::detectResets(const float* phasor, int stride, int n, uint32_t* resets) {
+    for (int frame = 0; frame < n; ++frame) {
+        uint32_t frameResets = 0;
+        for (int c = 0; c < numChannels; c += 4) {
+            float lanes[4] = {};
+            for (int k = 0; k < 4 && c + k < numChannels; ++k) {
+                lanes[k] = phasor[(c + k) * stride + frame];
+            }
+            const simd::float_4 normalizedPhasors = simd::clamp(simd::float_4::load(lanes), 0.f, 1.f);
+            frameResets |= (uint32_t)resetDetectors[c / 4](normalizedPhasors) << c;
+        }
+        resets[frame] = frameResets;
+    }
+}
+
+// Block core: runs one channel over n frames of a normalized (0-1) phasor and writes 0V/10V
+// levels to the six output buffers, in OutputIds order. resets holds the frames' reset bits from
+// detectResets(). Parameters are taken from the channel's current settings, so callers refresh
+// them (processControlRate) between blocks. The deferred pattern work runs frame by frame, so a
+// block gives the same output as n calls with n = 1.
+void PhasorBeatMap::processBlock(const float* phasor, const uint32_t* resets, int n, float* outs[6], int c) {
+    HCVPhasorAnalyzer& analyzer = phasorAnalyzer[c];
+
+    // Output levels as a bitmask (bit i = output i high), written out as spans when they change
+    uint32_t levels = 0;
+    int spanStart = 0;
+
+    for (int frame = 0; frame < n; ++frame) {
+        // Mode changes, resets and new lanes draw a fresh bar. The first bar after loading waits for
+        // the lane's slot, or for the first step the phasor actually moves to, whichever comes first.
+        if (firstBarDelay[c] > 0) {
+            --firstBarDelay[c];
+        }
+        if (barCache[c]->needsRegeneration && firstBarDelay[c] == 0) {
+            generateChannelBar(c);
+        }
+
+        // Carry on with parameter updates, starting at the step under the playhead
+        if (barCache[c]->staleSteps != 0) {
+            updateBarSteps(c, *barCache[c], getPlayheadStep(c));
+        }
+        if (pendingReady[c] && pendingBar[c]->staleSteps != 0) {
+            updateBarSteps(c, *pendingBar[c], 0);
+        }
+
+        // The next chaos bar is built ahead of time, from the lane's slot on, so the bar boundary
+        // only swaps
+        if (pendingDelay[c] > 0) {
+            --pendingDelay[c];
+        }
+        if (!pendingReady[c] && pendingDelay[c] == 0 && chaos[c] > 0.0f && !barCache[c]->needsRegeneration) {
+            continuePendingBar(c);
+        }
+
+        analyzer(clamp(phasor[frame], 0.f, 1.f), (resets[frame] >> c) & 1);
+
+        // Move on to the next bar on phasor resets if chaos is active. Resets also time the bar,
+        // which bounds how long the next pending bar may wait for its slot.
+        if (analyzer.getReset()) {
+            barFrames[c] = channelFrame[c] - lastResetFrame[c];
+            lastResetFrame[c] = channelFrame[c];
+            if (chaos[c] > 0.0f && !freezeActive) {
+                advanceChannelBar(c);
+            }
+        }
+
+        // Check for step changes. A change on the lane's first sample only locates the playhead,
+        // any later one is a step to play. Crossings only ever come from the phasor moving.
+        if (analyzer.getStepChanged()) {
+            if (activeStepTriggerMode == STEP_CROSSINGS) {
+                HCVPhasorStepCrossings& crossings = analyzer.getStepCrossings();
+                for (int e = 0; e < crossings.getNumEvents(); ++e) {
+                    const HCVPhasorStepEvent& event = crossings.getEvent(e);
+                    playStep(c, event.step, true, 1.0f - event.offset);
+                }
+            } else {
+                playStep(c, analyzer.getCurrentStep(), phasorLocated[c], analyzer.getStepOffset());
+            }
+        }
+        phasorLocated[c] = true;
+
+        // Falling edges due this frame
+        for (int i = pulseEdges[c].popDue(channelFrame[c]); i >= 0; i = pulseEdges[c].popDue(channelFrame[c])) {
+            pulseLevels[c] &= ~(1u << i);
+        }
+        ++channelFrame[c];
+
+        uint32_t frameLevels = 0;
+        if (triggerOutputMode == GATE) {
+            // Gate mode: output high for first 50% of step if trigger is active
+            const BarCache& bar = *barCache[c];
+            int currentStep = clamp(analyzer.getCurrentStep(), 0, activeBarLength - 1);
+            uint32_t firstHalf = analyzer.getGate();
+
+            for (int i = 0; i < 3; ++i) {
+                uint32_t gateHigh = (uint32_t)(bar.triggerMask[i] >> currentStep) & firstHalf;
+                uint32_t accentGateHigh = (uint32_t)(bar.accentMask[i] >> currentStep) & gateHigh;
+                frameLevels |= (gateHigh << i) | (accentGateHigh << (i + 3));
+            }
+        } else {
+            frameLevels = pulseLevels[c];
+        }
+
+        if (frameLevels != levels) {
+            writeOutputSpans(outs, levels, spanStart, frame);
+            levels = frameLevels;
+            spanStart = frame;
+        }
+    }
+    writeOutputSpans(outs, levels, spanStart, n);
+}
+
+void PhasorBeatMap::writeOutputSpans(float* outs[6], uint32_t levels, int from, int to) {
+    for (int i = 0; i < 6; ++i) {
+        std::fill(outs[i] + from, outs[i] + to, ((levels >> i) & 1) ? 10.0f : 0.0f);
+    }
+}
+
+// Point the shared pattern generator at a channel's settings
+void PhasorBeatMap::applyChannelSettings(int c) {
+    patternGenerator.setPatternMode(toPatternMode(channelMode[c]));
+    patternGenerator.setBarLength(activeBarLength);
+    patternGenerator.setMapX(mapX[c]);
+    patternGenerator.setMapY(mapY[c]);
+    patternGenerator.setBDDensity(BDFill[c]);
+    patternGenerator.setSDDensity(SNFill[c]);
+    patternGenerator.setHHDensity(HHFill[c]);
+    patternGenerator.setRandomness(chaos[c]);
+    patternGenerator.setEuclideanLength(0, mapX[c]);
+    patternGenerator.setEuclideanLength(1, mapY[c]);
+    patternGenerator.setEuclideanLength(2, chaos[c]);
+    patternGenerator.setRandomState(randomState[c]);
+}
+
+void PhasorBeatMap::generateChannelBar(int c) {
+    applyChannelSettings(c);
+    patternGenerator.generateBar(*barCache[c]);
+    randomState[c] = patternGenerator.getRandomState();
+    firstBarDelay[c] = 0;
+}
+
+// One stage of the pending bar: stage 0 draws it, stages 1 to kNumParts build a part each and the
+// last one finishes it
+void PhasorBeatMap::continuePendingBar(int c) {
+    BarCache& pending = *pendingBar[c];
+    applyChannelSettings(c);
+
+    const int stage = pendingStage[c];
+    if (stage == 0) {
+        patternGenerator.beginBar(pending);
+        randomState[c] = patternGenerator.getRandomState();
+    } else if (stage <= kNumParts) {
+        patternGenerator.generateBarPart(pending, stage - 1);
+    } else {
+        patternGenerator.finishBar(pending);
+        pendingStage[c] = 0;
+        pendingReady[c] = true;
+        return;
+    }
+    ++pendingStage[c];
+}
+
+// Bar boundary: the pending bar starts playing and the lane waits for its slot to draw the next one.
+// Either way the boundary itself only swaps pointers.
+void PhasorBeatMap::advanceChannelBar(int c) {
+    if (barCache[c]->needsRegeneration) {
+        generateChannelBar(c);
+        return;
+    }
+
+    // A bar shorter than the lane's slot delay and build time plays again, and the pending bar is
+    // built from here on without waiting, for the next boundary
+    if (!pendingReady[c]) {
+        pendingDelay[c] = 0;
+        return;
+    }
+
+    // Steps left stale by a parameter change are rebuilt from the playhead once the bar plays
+    pendingBar[c]->generation = barCache[c]->generation + 1;
+    std::swap(barCache[c], pendingBar[c]);
+    pendingReady[c] = false;
+    pendingDelay[c] = BarScheduler::slotDelay(schedulerTicket, c, barFrames[c] / kSlotDelayShare);
+}
+
+// Rebuild the next kStepsPerUpdate steps of a bar from the channel's settings, from the first
+// stale one at or after step
+void PhasorBeatMap::updateBarSteps(int c, BarCache& bar, int step) {
+    applyChannelSettings(c);
+
+    // With fresh settings every step is stale, which generateSteps() only notes on its first call
+    const uint64_t stale = bar.staleSteps;
+    const uint64_t ahead = step == 0 ? stale : (stale >> step) | (stale << (activeBarLength - step));
+    const int from = ahead == 0 ? step : (step + __builtin_ctzll(ahead)) % activeBarLength;
+    patternGenerator.generateSteps(bar, from, std::min(kStepsPerUpdate, activeBarLength - from));
+}
+
+int PhasorBeatMap::getPlayheadStep(int c) {
+    return clamp(phasorAnalyzer[c].getCurrentStep(), 0, activeBarLength - 1);
+}
+
+// Throw away both bars; the playing one is redrawn before its next use
+void PhasorBeatMap::requestRegeneration(int c) {
+    barCache[c]->needsRegeneration = true;
+    pendingStage[c] = 0;
+    pendingReady[c] = false;
+}
+
+PatternGeneratorMode PhasorBeatMap::toPatternMode(SequencerMode mode) {
+    switch (mode) {
+        case HENRI:
+            return PATTERN_HENRI;
+        case EUCLIDEAN:
+            return PATTERN_EUCLIDEAN;
+        case ORIGINAL:
+        default:
+            return PATTERN_ORIGINAL;
+    }
 }
 
 void PhasorBeatMap::updateUI() {
+    for (int i = ledEdges.popDue(uiFrame); i >= 0; i = ledEdges.popDue(uiFrame)) {
+        ledLevels &= ~(1u << i);
+    }
+    ++uiFrame;
+
     for(int i = 0; i < 3; ++i) {
-        drumLED[i].process();
-        lights[drumLEDIds[i]].value = drumLED[i].getState() ? 1.0f : 0.0f;
+        lights[drumLEDIds[i]].value = ((ledLevels >> i) & 1) ? 1.0f : 0.0f;
     }
 }
 
-// Trigger outputs for a specific step based on cached bar data
-void PhasorBeatMap::triggerStepOutputs(int step) {
-    step = clamp(step, 0, 31);
-    const BarCache::StepData& data = barCache.steps[step];
+// Channel c's stream starts where the generator's would for seed + c, so channel 0 draws what a
+// single-channel instance with this seed always has
+void PhasorBeatMap::setSeed(uint32_t seed) {
+    for (int c = 0; c < HCV_MAX_POLYPHONY; ++c) {
+        patternGenerator.setSeed(seed + c);
+        randomState[c] = patternGenerator.getRandomState();
+    }
+    patternGenerator.setSeed(seed);
+}
+
+// Pulse widths in frames: 1 ms for the outputs, 100 ms for the LEDs. Pending falling edges keep
+// the same share of their time left.
+void PhasorBeatMap::setPulseSampleRate(float sampleRate) {
+    if (pulseSampleRate > 0.0f) {
+        const float ratio = sampleRate / pulseSampleRate;
+        for (int c = 0; c < HCV_MAX_POLYPHONY; ++c) {
+            pulseEdges[c].rescale(channelFrame[c], ratio);
+        }
+        ledEdges.rescale(uiFrame, ratio);
+    }
+    pulseSampleRate = sampleRate;
+    pulseFrames = std::max((int)std::lround(0.001f * sampleRate), 1);
+    ledFrames = std::max((int)std::lround(0.1f * sampleRate), 1);
+}
+
+void PhasorBeatMap::publishDisplaySnapshot() {
+    BarSnapshot& snapshot = displaySnapshot.back();
+    const BarCache& bar = *barCache[0];
+    for (int i = 0; i < kNumParts; ++i) {
+        snapshot.triggerMask[i] = bar.triggerMask[i];
+        snapshot.accentMask[i] = bar.accentMask[i];
+    }
+    snapshot.generation = bar.generation;
+    snapshot.length = activeBarLength;
+    snapshot.step = clamp(phasorAnalyzer[0].getCurrentStep(), 0, activeBarLength - 1);
+    snapshot.fractionalStep = phasorAnalyzer[0].getFractionalStep();
+    displaySnapshot.publish();
+}
+
+// A step the phasor arrived at this frame. A step the phasor moved to can't wait for a deferred
+// first bar.
+// offset is how far the step boundary lies before the current frame, in samples (0 to 1)
+void PhasorBeatMap::playStep(int c, int step, bool phasorMoved, float offset) {
+    if (barCache[c]->needsRegeneration && phasorMoved) {
+        generateChannelBar(c);
+    }
+
+    // The step about to fire is always up to date, whatever the update got to so far
+    const int firingStep = clamp(step, 0, activeBarLength - 1);
+    if ((barCache[c]->staleSteps >> firingStep) & 1) {
+        applyChannelSettings(c);
+        patternGenerator.generateSteps(*barCache[c], firingStep, 1);
+    }
+    triggerStepOutputs(c, step, offset);
+    lastStep[c] = step;
+}
+
+// Trigger outputs for a specific step based on cached bar data. Pulses start on the current frame,
+// the first at or after the boundary, and end pulseFrames after the boundary, rounded to a frame.
+void PhasorBeatMap::triggerStepOutputs(int c, int step, float offset) {
+    step = clamp(step, 0, activeBarLength - 1);
+    const BarCache& bar = *barCache[c];
+    const uint32_t fallingEdge = channelFrame[c] + std::max(pulseFrames - (offset >= 0.5f ? 1 : 0), 1);
 
     for (int i = 0; i < 3; ++i) {
-        if (data.trigger[i]) {
-            drumTriggers[i].trigger();
-            drumLED[i].trigger();
+        if (bar.getTrigger(step, i)) {
+            uint32_t triggered = 1u << i;
 
             // Trigger accent output if accent is set
-            if (data.accent[i]) {
-                drumTriggers[i + 3].trigger();
+            if (bar.getAccent(step, i)) {
+                triggered |= 1u << (i + 3);
+                pulseEdges[c].schedule(i + 3, fallingEdge);
             }
+            pulseEdges[c].schedule(i, fallingEdge);
+            pulseLevels[c] |= triggered;
+
+            ledEdges.schedule(i, uiFrame + ledFrames);
+            ledLevels |= 1u << i;
         }
     }
 }
 
 void PhasorBeatMap::onSampleRateChange() {
-    for(int i = 0; i < 3; ++i) {
-        drumLED[i].setSampleRate(APP->engine->getSampleRate());
-    }
-    for(int i = 0; i < 6; ++i) {
-        drumTriggers[i].setSampleRate(APP->engine->getSampleRate());
-    }
+    HCVModule::onSampleRateChange();
+    setPulseSampleRate(APP->engine->getSampleRate());
 }
 
 void PhasorBeatMap::onReset(const ResetEvent& e) {
     Module::onReset(e);
-    barCache.needsRegeneration = true;
+    parametersDirty = true;
+    for (int c = 0; c < HCV_MAX_POLYPHONY; ++c) {
+        requestRegeneration(c);
+    }
 }
 
 void PhasorBeatMap::onRandomize(const RandomizeEvent& e) {
@@ -245,44 +629,35 @@ void PhasorBeatMap::onRandomize(const RandomizeEvent& e) {
     params[PhasorBeatMap::BD_DENS_PARAM].setValue(random::uniform());
     params[PhasorBeatMap::SN_DENS_PARAM].setValue(random::uniform());
     params[PhasorBeatMap::HH_DENS_PARAM].setValue(random::uniform());
-    barCache.needsRegeneration = true;
+    parametersDirty = true;
+    for (int c = 0; c < HCV_MAX_POLYPHONY; ++c) {
+        requestRegeneration(c);
+    }
 }
 
-// NEW: Check if bar needs regeneration based on parameter changes
-bool PhasorBeatMap::checkBarRegenerationNeeded() {
-    // Get current parameter values (as uint8_t to match cache storage)
-    uint8_t currentMapX = static_cast<uint8_t>(mapX * 255.0f);
-    uint8_t currentMapY = static_cast<uint8_t>(mapY * 255.0f);
-    uint8_t currentRandomness = static_cast<uint8_t>(chaos * 255.0f);
-    uint8_t currentBDDensity = static_cast<uint8_t>(BDFill * 255.0f);
-    uint8_t currentSNDensity = static_cast<uint8_t>(SNFill * 255.0f);
-    uint8_t currentHHDensity = static_cast<uint8_t>(HHFill * 255.0f);
-
-    // Check if any parameters changed
+// NEW: Check if the settings a bar was built with differ from the channel's current ones
+bool PhasorBeatMap::checkBarSettingsChanged(int c, const BarCache& bar) {
+    // Get current parameter values (quantized the same way as the pattern generator's settings)
+    uint8_t currentMapX = static_cast<uint8_t>(mapX[c] * 255.0);
+    uint8_t currentMapY = static_cast<uint8_t>(mapY[c] * 255.0);
+    uint8_t currentRandomness = static_cast<uint8_t>(chaos[c] * 255.0);
+    uint8_t currentBDDensity = static_cast<uint8_t>(BDFill[c] * 255.0);
+    uint8_t currentSNDensity = static_cast<uint8_t>(SNFill[c] * 255.0);
+    uint8_t currentHHDensity = static_cast<uint8_t>(HHFill[c] * 255.0);
+
+    // Check if any parameters changed. In Euclidean mode the x, y and chaos values also set the
+    // euclidean lengths, so they are covered by the same comparisons.
     bool changed = (
-        currentMapX != barCache.lastMapX ||
-        currentMapY != barCache.lastMapY ||
-        currentRandomness != barCache.lastRandomness ||
-        currentBDDensity != barCache.lastDensity[0] ||
-        currentSNDensity != barCache.lastDensity[1] ||
-        currentHHDensity != barCache.lastDensity[2] ||
-        sequencerMode != static_cast<int>(barCache.lastPatternMode)
+        currentMapX != bar.lastMapX ||
+        currentMapY != bar.lastMapY ||
+        currentRandomness != bar.lastRandomness ||
+        currentBDDensity != bar.lastDensity[0] ||
+        currentSNDensity != bar.lastDensity[1] ||
+        currentHHDensity != bar.lastDensity[2] ||
+        toPatternMode(channelMode[c]) != bar.lastPatternMode
     );
 
-    // For Euclidean mode, also check euclidean lengths
-    if (sequencerMode == EUCLIDEAN) {
-        uint8_t currentEucX = static_cast<uint8_t>(mapX * 255.0f);
-        uint8_t currentEucY = static_cast<uint8_t>(mapY * 255.0f);
-        uint8_t currentEucChaos = static_cast<uint8_t>(chaos * 255.0f);
-
-        changed = changed || (
-            currentEucX != barCache.lastEuclideanLength[0] ||
-            currentEucY != barCache.lastEuclideanLength[1] ||
-            currentEucChaos != barCache.lastEuclideanLength[2]
-        );
-    }
-
-    return changed || barCache.needsRegeneration;
+    return changed;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -326,6 +701,9 @@ PhasorBeatMapWidget::PhasorBeatMapWidget(PhasorBeatMap *module)
     createHCVRedLight(138.6, 218, PhasorBeatMap::BD_LIGHT);
     createHCVRedLight(174.6, 218, PhasorBeatMap::SN_LIGHT);
     createHCVRedLight(210.6, 218, PhasorBeatMap::HH_LIGHT);
+
+    // Pattern display, in the strip between the output box and the panel lettering and screws
+    addChild(new PhasorBeatMapDisplay(module, Vec(99, 345), Vec(132, 17)));
 }
 
 void PhasorBeatMapWidget::appendContextMenu(Menu* menu) {
@@ -339,6 +717,100 @@ void PhasorBeatMapWidget::appendContextMenu(Menu* menu) {
         [=]() { return module->triggerOutputMode; },
         [=](int mode) { module->triggerOutputMode = (PhasorBeatMap::TriggerOutputMode)mode; }
     ));
+
+    // How often params and CV are read; step detection always runs every sample
+    menu->addChild(createIndexSubmenuItem("Parameter Rate",
+        {"Every sample", "Every 8 samples", "Every 32 samples", "Every 128 samples"},
+        [=]() {
+            for (int i = 0; i < PhasorBeatMap::kNumControlRates; ++i) {
+                if (PhasorBeatMap::kControlRateDivisions[i] == module->controlRateDivision) return i;
+            }
+            return 0;
+        },
+        [=](int rate) { module->setControlRateDivision(PhasorBeatMap::kControlRateDivisions[rate]); }
+    ));
+
+    menu->addChild(createIndexSubmenuItem("Bar Length",
+        {"8 steps", "12 steps", "16 steps", "24 steps", "32 steps", "48 steps", "64 steps"},
+        [=]() {
+            for (int i = 0; i < PhasorBeatMap::kNumBarLengths; ++i) {
+                if (PhasorBeatMap::kBarLengths[i] == module->barLength) return i;
+            }
+            return (int)PhasorBeatMap::kNumBarLengths;
+        },
+        [=](int length) { module->setBarLength(PhasorBeatMap::kBarLengths[length]); }
+    ));
+
+    menu->addChild(createIndexSubmenuItem("Step Triggers", {"On step change", "Every crossed step"},
+        [=]() { return module->stepTriggerMode; },
+        [=](int mode) { module->setStepTriggerMode((PhasorBeatMap::StepTriggerMode)mode); }
+    ));
+}
+
+void PhasorBeatMapGrid::draw(const DrawArgs& args) {
+    const float cellWidth = box.size.x / length;
+    const float cellHeight = box.size.y / kNumParts;
+
+    nvgBeginPath(args.vg);
+    nvgRect(args.vg, 0, 0, box.size.x, box.size.y);
+    nvgFillColor(args.vg, nvgRGB(0x1D, 0x1D, 0x1D));
+    nvgFill(args.vg);
+
+    for (int i = 0; i < kNumParts; ++i) {
+        for (int step = 0; step < length; ++step) {
+            if (!((triggerMask[i] >> step) & 1)) continue;
+            const bool accent = (accentMask[i] >> step) & 1;
+            nvgBeginPath(args.vg);
+            nvgRect(args.vg, step * cellWidth + 0.5f, i * cellHeight + 1.0f, cellWidth - 1.0f, cellHeight - 2.0f);
+            nvgFillColor(args.vg, accent ? partColours[i] : nvgTransRGBA(partColours[i], 0x80));
+            nvgFill(args.vg);
+        }
+    }
+}
+
+PhasorBeatMapDisplay::PhasorBeatMapDisplay(PhasorBeatMap* _module, Vec _pos, Vec _size) {
+    module = _module;
+    box.pos = _pos;
+    box.size = _size;
+
+    gridBuffer = new FramebufferWidget;
+    gridBuffer->box.size = _size;
+    addChild(gridBuffer);
+
+    grid = new PhasorBeatMapGrid;
+    grid->box.size = _size;
+    gridBuffer->addChild(grid);
+}
+
+void PhasorBeatMapDisplay::step() {
+    // Module browser previews have no module, and keep the empty grid
+    if (module && module->displaySnapshot.fetch()) {
+        const BarSnapshot& snapshot = module->displaySnapshot.front();
+        if (!gridDrawn || snapshot.generation != drawnGeneration) {
+            for (int i = 0; i < kNumParts; ++i) {
+                grid->triggerMask[i] = snapshot.triggerMask[i];
+                grid->accentMask[i] = snapshot.accentMask[i];
+            }
+            grid->length = snapshot.length;
+            drawnGeneration = snapshot.generation;
+            gridDrawn = true;
+            gridBuffer->dirty = true;
+        }
+    }
+    TransparentWidget::step();
+}
+
+void PhasorBeatMapDisplay::draw(const DrawArgs& args) {
+    TransparentWidget::draw(args);
+    if (!module) return;
+
+    // Playhead, drawn over the cached grid
+    const BarSnapshot& snapshot = module->displaySnapshot.front();
+    const float cellWidth = box.size.x / snapshot.length;
+    nvgBeginPath(args.vg);
+    nvgRect(args.vg, (snapshot.step + snapshot.fractionalStep) * cellWidth - 0.5f, 0, 1.0f, box.size.y);
+    nvgFillColor(args.vg, nvgRGB(0xFF, 0xFF, 0xFF));
+    nvgFill(args.vg);
 }
 
 void PhasorBeatMapWidget::step() {
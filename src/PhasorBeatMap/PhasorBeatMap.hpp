@@ -24,14 +24,16 @@
 #pragma once
 #include "../PhasorBeatMapPlugin.hpp"
 #include "../gui/ValleyComponents.hpp"
-#include "../timers/Oneshot.hpp"
+#include "../timers/EdgeScheduler.hpp"
 #include "../DSP/Phasors/HCVPhasorAnalyzers.h"
 #include "PhasorBeatMapPatternGenerator.hpp"
+#include "PhasorBeatMapSnapshot.hpp"
+#include "PhasorBeatMapScheduler.hpp"
 #include "../HetrickUtilities.hpp"
 #include <iomanip> // setprecision
 #include <sstream> // stringstream
 
-struct PhasorBeatMap : Module {
+struct PhasorBeatMap : HCVModule {
    enum ParamIds {
        MAPX_PARAM,
        MAPY_PARAM,
@@ -73,39 +75,114 @@ struct PhasorBeatMap : Module {
        NUM_LIGHTS
    };
 
-   // Pattern generation
+   enum SequencerMode {
+       ORIGINAL,
+       HENRI,
+       EUCLIDEAN,
+       NUM_SEQUENCER_MODES
+   };
+
+   // Pattern generation. The generator holds no per-channel state, so one instance (and its
+   // drum map cache) is shared by every channel and pointed at a channel's settings before use.
+   // Each channel draws its chaos from its own random stream (randomState), seeded from the
+   // instance's seed, so a channel's bars don't depend on when the other channels drew theirs.
    PatternGenerator patternGenerator;
-   BarCache barCache;
+   uint32_t randomState[HCV_MAX_POLYPHONY];
+   int numChannels = 1;
+
+   // Per-channel state, stored structure-of-arrays and indexed by polyphony channel.
+   // barCache plays while pendingBar holds the next chaos bar. From the lane's scheduler slot on,
+   // the pending bar is built one stage per sample (pendingStage: the draw, each part, the finish),
+   // and at the bar boundary the two pointers swap. A boundary that comes before the pending bar is
+   // ready plays the current bar again instead of finishing the build there and then.
+   BarCache barBuffers[2][HCV_MAX_POLYPHONY];
+   BarCache* barCache[HCV_MAX_POLYPHONY];
+   BarCache* pendingBar[HCV_MAX_POLYPHONY];
+   int pendingStage[HCV_MAX_POLYPHONY];
+   bool pendingReady[HCV_MAX_POLYPHONY];
+   HCVPhasorAnalyzer phasorAnalyzer[HCV_MAX_POLYPHONY];
+   HCVPhasorResetDetector4 resetDetectors[HCV_MAX_POLYPHONY / 4];
+   int lastStep[HCV_MAX_POLYPHONY];
 
-   // Phasor processing
-   HCVPhasorStepDetector stepDetector;
-   HCVPhasorResetDetector resetDetector;
-   int lastStep = -1;
+   // Set once a lane's analyzer has seen its first sample. Until then a step change only locates
+   // the playhead; from then on it is the phasor moving.
+   bool phasorLocated[HCV_MAX_POLYPHONY];
+
+   // Parameter changes rebuild a Euclidean bar this many steps per sample, nearest the playhead
+   // first. Drum bars are rebuilt whole on the first of them (PatternGenerator::generateSteps).
+   static const int kStepsPerUpdate = 4;
+
+   // Deferred pattern work, in frames still to wait (see BarScheduler). The first bar after loading
+   // waits for the lane's slot, and so does the pending bar after every swap, but for no more than
+   // 1 / kSlotDelayShare of the lane's last bar (barFrames, frames between its last two resets).
+   static const int kSlotDelayShare = 4;
+   uint32_t schedulerTicket;
+   int firstBarDelay[HCV_MAX_POLYPHONY];
+   int pendingDelay[HCV_MAX_POLYPHONY];
+   uint32_t lastResetFrame[HCV_MAX_POLYPHONY] = {};
+   uint32_t barFrames[HCV_MAX_POLYPHONY] = {};
    bool freezeActive = false;  // For future freeze input
 
    // Pattern parameters
-   float mapX = 0.0;
-   float mapY = 0.0;
-   float chaos = 0.0;
-   float BDFill = 0.0;
-   float SNFill = 0.0;
-   float HHFill = 0.0;
-
-   // LED Triggers
-   Oneshot drumLED[3];
-   const LightIds drumLEDIds[3] = {BD_LIGHT, SN_LIGHT, HH_LIGHT};
+   float mapX[HCV_MAX_POLYPHONY] = {};
+   float mapY[HCV_MAX_POLYPHONY] = {};
+   float chaos[HCV_MAX_POLYPHONY] = {};
+   float BDFill[HCV_MAX_POLYPHONY] = {};
+   float SNFill[HCV_MAX_POLYPHONY] = {};
+   float HHFill[HCV_MAX_POLYPHONY] = {};
+   SequencerMode channelMode[HCV_MAX_POLYPHONY];
 
-   // Drum Triggers
-   Oneshot drumTriggers[6];
+   // Drum trigger pulses as output levels (bit i = output i high). A trigger raises the level and
+   // schedules its falling edge pulseFrames after the step boundary, to the nearest frame of the
+   // channel's own frame count, so idle outputs cost nothing and pulses end where they would have
+   // if they had started on the boundary itself.
+   uint32_t pulseLevels[HCV_MAX_POLYPHONY] = {};
+   EdgeScheduler<6> pulseEdges[HCV_MAX_POLYPHONY];
+   uint32_t channelFrame[HCV_MAX_POLYPHONY] = {};
+   int pulseFrames = 1;
    const OutputIds outIDs[6] = {BD_OUTPUT, SN_OUTPUT, HH_OUTPUT,
                                 BD_ACC_OUTPUT, SN_ACC_OUTPUT, HH_ACC_OUTPUT};
 
-   enum SequencerMode {
-       ORIGINAL,
-       HENRI,
-       EUCLIDEAN,
-       NUM_SEQUENCER_MODES
+   // LEDs, fired by any channel and timed in process() calls
+   uint32_t ledLevels = 0;
+   EdgeScheduler<3> ledEdges;
+   uint32_t uiFrame = 0;
+   int ledFrames = 1;
+   const LightIds drumLEDIds[3] = {BD_LIGHT, SN_LIGHT, HH_LIGHT};
+   float pulseSampleRate = 0.0f;
+
+   // Control-rate parameter path. Params and CV are read every controlRateDivision samples, and
+   // only when a CV input is patched or a param, the channel count or the patched set changed.
+   static const int kNumControlRates = 4;
+   static const int kControlRateDivisions[kNumControlRates];
+   int controlRateDivision = 32;
+   dsp::ClockDivider controlDivider;
+   float lastParamValues[NUM_PARAMS] = {};
+   uint32_t connectedCVInputs = 0;
+   int lastNumChannels = 0;
+   bool parametersDirty = true;
+
+   // Steps per bar, 1 to kMaxStepsPerPattern. barLength is the requested length; the engine picks
+   // it up at control rate, resizing the phasor analyzers and redrawing every lane's bars.
+   static const int kNumBarLengths = 7;
+   static const int kBarLengths[kNumBarLengths];
+   int barLength = kStepsPerPattern;
+   int activeBarLength = kStepsPerPattern;
+
+   // Step triggers: on step changes, or for every step the phasor crosses, so scrubbing and jumps
+   // play each step they pass (HCVPhasorStepCrossings). Picked up at control rate like barLength.
+   enum StepTriggerMode {
+       STEP_CHANGES,
+       STEP_CROSSINGS
    };
+   StepTriggerMode stepTriggerMode = STEP_CHANGES;
+   StepTriggerMode activeStepTriggerMode = STEP_CHANGES;
+
+   // Bar and playhead of the first channel, published for the panel display
+   TripleBuffer<BarSnapshot> displaySnapshot;
+   dsp::ClockDivider displayDivider;
+
+   // Mode of the first channel, shown on the panel
    SequencerMode sequencerMode = ORIGINAL;
    int inEuclideanMode = 0;
 
@@ -126,10 +203,62 @@ struct PhasorBeatMap : Module {
    void onReset(const ResetEvent& e) override;
    void onRandomize(const RandomizeEvent& e) override;
    void updateUI();
+   void setSeed(uint32_t seed);
+   void setPulseSampleRate(float sampleRate);
+   void publishDisplaySnapshot();
 
    // Phasor-based playback methods
-   bool checkBarRegenerationNeeded();
-   void triggerStepOutputs(int step);
+   void setControlRateDivision(int division);
+   void setBarLength(int length);
+   void setStepTriggerMode(StepTriggerMode mode);
+   void processControlRate();
+   uint32_t getConnectedCVInputs();
+   bool checkParamsChanged();
+   void readChannelParameters();
+   void detectResets(const float* phasor, int stride, int n, uint32_t* resets);
+
+   // One channel over n frames. Unlike a plain processBlock(phasor, n, outs), it takes the frames'
+   // reset bits, which detectResets() has to have worked out first for all channels at once: the
+   // reset detectors run four lanes at a time. Pattern work runs per frame and parameters are only
+   // read by processControlRate(), so with the same parameters a block is sample for sample the
+   // same as n calls with n = 1.
+   void processBlock(const float* phasor, const uint32_t* resets, int n, float* outs[6], int channel = 0);
+   static void writeOutputSpans(float* outs[6], uint32_t levels, int from, int to);
+   void applyChannelSettings(int channel);
+   void generateChannelBar(int channel);
+   void continuePendingBar(int channel);
+   void advanceChannelBar(int channel);
+   void requestRegeneration(int channel);
+   void updateBarSteps(int channel, BarCache& bar, int step);
+   int getPlayheadStep(int channel);
+   bool checkBarSettingsChanged(int channel, const BarCache& bar);
+   void playStep(int channel, int step, bool phasorMoved, float offset);
+   void triggerStepOutputs(int channel, int step, float offset);
+   static PatternGeneratorMode toPatternMode(SequencerMode mode);
+};
+
+// Bar length x 3 grid of one bar's triggers (dimmed) and accents (full colour)
+struct PhasorBeatMapGrid : TransparentWidget {
+    uint64_t triggerMask[kNumParts] = {};
+    uint64_t accentMask[kNumParts] = {};
+    int length = kStepsPerPattern;
+    NVGcolor partColours[kNumParts] = {nvgRGB(0xE8, 0x2C, 0x2C), nvgRGB(0xF0, 0x8A, 0x24), nvgRGB(0xF2, 0xD0, 0x2E)};
+
+    void draw(const DrawArgs& args) override;
+};
+
+// Shows the first channel's bar. The grid is cached in a framebuffer that is only redrawn when
+// the bar's generation changes; the playhead is drawn over it every frame.
+struct PhasorBeatMapDisplay : TransparentWidget {
+    PhasorBeatMap* module;
+    FramebufferWidget* gridBuffer;
+    PhasorBeatMapGrid* grid;
+    uint32_t drawnGeneration = 0;
+    bool gridDrawn = false;
+
+    PhasorBeatMapDisplay(PhasorBeatMap* _module, Vec _pos, Vec _size);
+    void step() override;
+    void draw(const DrawArgs& args) override;
 };
 
 struct PhasorBeatMapWidget : HCVModuleWidget {
@@ -0,0 +1,168 @@
+//
+// PhasorBeatMapBarKernel.cpp
+// Whole-bar drum map kernels for PhasorBeatMap.
+//
+// This source code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "PhasorBeatMapBarKernel.hpp"
+#include "PhasorBeatMapPatternGenerator.hpp"
+
+#if defined(PHASORBEATMAP_KERNEL_SSE2)
+#include <emmintrin.h>
+#elif defined(PHASORBEATMAP_KERNEL_NEON)
+#include <arm_neon.h>
+#endif
+
+void mixDrumMapLevelsScalar(const uint8_t* a, const uint8_t* b, const uint8_t* c, const uint8_t* d,
+                            uint8_t xBalance, uint8_t yBalance, uint8_t* out, int count) {
+    for (int i = 0; i < count; ++i) {
+        out[i] = U8Mix(U8Mix(a[i], b[i], xBalance), U8Mix(c[i], d[i], xBalance), yBalance);
+    }
+}
+
+void thresholdDrumLevelsScalar(const uint8_t* levels, uint8_t perturbation, uint8_t threshold,
+                               uint32_t* triggerBits, uint32_t* accentBits) {
+    uint32_t triggers = 0;
+    uint32_t accents = 0;
+    for (int step = 0; step < kBarKernelBlock; ++step) {
+        uint8_t level = levels[step];
+        if (level < 255 - perturbation) {
+            level += perturbation;
+        } else {
+            level = 255;
+        }
+        if (level > threshold) {
+            triggers |= 1u << step;
+            if (level > 192) {
+                accents |= 1u << step;
+            }
+        }
+    }
+    *triggerBits = triggers;
+    *accentBits = accents;
+}
+
+#if defined(PHASORBEATMAP_KERNEL_SSE2)
+
+// U8Mix on 8 zero-extended lanes. The sum never exceeds 255 * 255, where
+// (sum + 1 + (sum >> 8)) >> 8 equals sum / 255 exactly.
+static inline __m128i mixU16(__m128i a, __m128i b, __m128i balance, __m128i inverse) {
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, inverse), _mm_mullo_epi16(b, balance));
+    sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_srli_epi16(sum, 8), one));
+    return _mm_srli_epi16(sum, 8);
+}
+
+void mixDrumMapLevels(const uint8_t* a, const uint8_t* b, const uint8_t* c, const uint8_t* d,
+                      uint8_t xBalance, uint8_t yBalance, uint8_t* out, int count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i x = _mm_set1_epi16(xBalance);
+    const __m128i xInverse = _mm_set1_epi16(255 - xBalance);
+    const __m128i y = _mm_set1_epi16(yBalance);
+    const __m128i yInverse = _mm_set1_epi16(255 - yBalance);
+
+    for (int i = 0; i < count; i += 16) {
+        const __m128i a8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i b8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        const __m128i c8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + i));
+        const __m128i d8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d + i));
+
+        const __m128i abLow = mixU16(_mm_unpacklo_epi8(a8, zero), _mm_unpacklo_epi8(b8, zero), x, xInverse);
+        const __m128i abHigh = mixU16(_mm_unpackhi_epi8(a8, zero), _mm_unpackhi_epi8(b8, zero), x, xInverse);
+        const __m128i cdLow = mixU16(_mm_unpacklo_epi8(c8, zero), _mm_unpacklo_epi8(d8, zero), x, xInverse);
+        const __m128i cdHigh = mixU16(_mm_unpackhi_epi8(c8, zero), _mm_unpackhi_epi8(d8, zero), x, xInverse);
+
+        const __m128i low = mixU16(abLow, cdLow, y, yInverse);
+        const __m128i high = mixU16(abHigh, cdHigh, y, yInverse);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+    }
+}
+
+// Bit i set where lane i of the unsigned bytes is greater than the limit.
+static inline uint32_t greaterThanBits(__m128i levels, __m128i limit) {
+    const __m128i notGreater = _mm_cmpeq_epi8(_mm_subs_epu8(levels, limit), _mm_setzero_si128());
+    return ~static_cast<uint32_t>(_mm_movemask_epi8(notGreater)) & 0xFFFF;
+}
+
+void thresholdDrumLevels(const uint8_t* levels, uint8_t perturbation, uint8_t threshold,
+                         uint32_t* triggerBits, uint32_t* accentBits) {
+    const __m128i offset = _mm_set1_epi8(static_cast<char>(perturbation));
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+    const __m128i accentLimit = _mm_set1_epi8(static_cast<char>(192));
+
+    const __m128i low = _mm_adds_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(levels)), offset);
+    const __m128i high = _mm_adds_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(levels + 16)), offset);
+
+    const uint32_t triggers = greaterThanBits(low, limit) | (greaterThanBits(high, limit) << 16);
+    const uint32_t accents = greaterThanBits(low, accentLimit) | (greaterThanBits(high, accentLimit) << 16);
+    *triggerBits = triggers;
+    *accentBits = accents & triggers;
+}
+
+#elif defined(PHASORBEATMAP_KERNEL_NEON)
+
+// U8Mix on 8 lanes, widened to 16 bits; see the SSE2 version for the division.
+static inline uint8x8_t mixU8(uint8x8_t a, uint8x8_t b, uint8x8_t balance, uint8x8_t inverse) {
+    uint16x8_t sum = vmlal_u8(vmull_u8(a, inverse), b, balance);
+    sum = vaddq_u16(sum, vaddq_u16(vshrq_n_u16(sum, 8), vdupq_n_u16(1)));
+    return vshrn_n_u16(sum, 8);
+}
+
+void mixDrumMapLevels(const uint8_t* a, const uint8_t* b, const uint8_t* c, const uint8_t* d,
+                      uint8_t xBalance, uint8_t yBalance, uint8_t* out, int count) {
+    const uint8x8_t x = vdup_n_u8(xBalance);
+    const uint8x8_t xInverse = vdup_n_u8(255 - xBalance);
+    const uint8x8_t y = vdup_n_u8(yBalance);
+    const uint8x8_t yInverse = vdup_n_u8(255 - yBalance);
+
+    for (int i = 0; i < count; i += 8) {
+        const uint8x8_t ab = mixU8(vld1_u8(a + i), vld1_u8(b + i), x, xInverse);
+        const uint8x8_t cd = mixU8(vld1_u8(c + i), vld1_u8(d + i), x, xInverse);
+        vst1_u8(out + i, mixU8(ab, cd, y, yInverse));
+    }
+}
+
+static inline uint32_t movemask(uint8x16_t mask) {
+    static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vandq_u8(mask, vld1q_u8(weights));
+    return vaddv_u8(vget_low_u8(bits)) | (static_cast<uint32_t>(vaddv_u8(vget_high_u8(bits))) << 8);
+}
+
+void thresholdDrumLevels(const uint8_t* levels, uint8_t perturbation, uint8_t threshold,
+                         uint32_t* triggerBits, uint32_t* accentBits) {
+    const uint8x16_t offset = vdupq_n_u8(perturbation);
+    const uint8x16_t limit = vdupq_n_u8(threshold);
+    const uint8x16_t accentLimit = vdupq_n_u8(192);
+
+    const uint8x16_t low = vqaddq_u8(vld1q_u8(levels), offset);
+    const uint8x16_t high = vqaddq_u8(vld1q_u8(levels + 16), offset);
+
+    const uint32_t triggers = movemask(vcgtq_u8(low, limit)) | (movemask(vcgtq_u8(high, limit)) << 16);
+    const uint32_t accents = movemask(vcgtq_u8(low, accentLimit)) | (movemask(vcgtq_u8(high, accentLimit)) << 16);
+    *triggerBits = triggers;
+    *accentBits = accents & triggers;
+}
+
+#else
+
+void mixDrumMapLevels(const uint8_t* a, const uint8_t* b, const uint8_t* c, const uint8_t* d,
+                      uint8_t xBalance, uint8_t yBalance, uint8_t* out, int count) {
+    mixDrumMapLevelsScalar(a, b, c, d, xBalance, yBalance, out, count);
+}
+
+void thresholdDrumLevels(const uint8_t* levels, uint8_t perturbation, uint8_t threshold,
+                         uint32_t* triggerBits, uint32_t* accentBits) {
+    thresholdDrumLevelsScalar(levels, perturbation, threshold, triggerBits, accentBits);
+}
+
+#endif
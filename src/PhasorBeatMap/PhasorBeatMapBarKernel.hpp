@@ -0,0 +1,50 @@
+//
+// PhasorBeatMapBarKernel.hpp
+// Whole-bar drum map kernels for PhasorBeatMap.
+//
+// This source code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// The drum map stores each node as 96 contiguous bytes (instrument * 32 + step), so a bar can be
+// computed 16 bytes at a time with unsigned saturating arithmetic. SSE2 and AArch64 NEON versions
+// are selected at compile time; the scalar versions are the reference they must match bit for bit.
+
+#ifndef PhasorBeatMapBarKernel_hpp
+#define PhasorBeatMapBarKernel_hpp
+
+#include <cstdint>
+
+#if defined(__SSE2__)
+#define PHASORBEATMAP_KERNEL_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define PHASORBEATMAP_KERNEL_NEON 1
+#endif
+
+// Kernels work on blocks of this many bytes; counts passed to them must be multiples of it.
+const int kBarKernelBlock = 32;
+
+// ORIGINAL mode interpolation: U8Mix(U8Mix(a, b, xBalance), U8Mix(c, d, xBalance), yBalance)
+// for count bytes of four node tables.
+void mixDrumMapLevels(const uint8_t* a, const uint8_t* b, const uint8_t* c, const uint8_t* d,
+                      uint8_t xBalance, uint8_t yBalance, uint8_t* out, int count);
+void mixDrumMapLevelsScalar(const uint8_t* a, const uint8_t* b, const uint8_t* c, const uint8_t* d,
+                            uint8_t xBalance, uint8_t yBalance, uint8_t* out, int count);
+
+// Applies a saturating perturbation to 32 step levels of one instrument and compares them against
+// the density threshold (trigger) and 192 (accent). Bit i of the masks is step i.
+void thresholdDrumLevels(const uint8_t* levels, uint8_t perturbation, uint8_t threshold,
+                         uint32_t* triggerBits, uint32_t* accentBits);
+void thresholdDrumLevelsScalar(const uint8_t* levels, uint8_t perturbation, uint8_t threshold,
+                               uint32_t* triggerBits, uint32_t* accentBits);
+
+#endif /* PhasorBeatMapBarKernel_hpp */
@@ -0,0 +1,115 @@
+//
+// PhasorBeatMapEuclidean.hpp
+// Compile-time Euclidean rhythm tables for PhasorBeatMap.
+//
+// This source code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// The tables follow the Grids resource script: for a length of L steps and a density level d
+// (0 to kEuclideanDensities - 1), round(d / 31 * L) notes are spread over the L steps with
+// Bjorklund's algorithm, and bit i of the pattern is step i. Patterns are looked up by
+// (length - 1) * kEuclideanDensities + density, like the original lut_res_euclidean.
+
+#ifndef PhasorBeatMapEuclidean_hpp
+#define PhasorBeatMapEuclidean_hpp
+
+#include <cstdint>
+#include <type_traits>
+
+const int kEuclideanDensities = 32;
+const int kMaxEuclideanLength = 64;
+
+// Notes for a density level, rounded half up. d * L / 31 is never exactly halfway for L <= 64.
+constexpr int euclideanNotes(int density, int length) {
+    return (2 * density * length + (kEuclideanDensities - 1)) / (2 * (kEuclideanDensities - 1));
+}
+
+// The tables are built by C++11 constexpr functions, so every loop is written as recursion.
+
+// A pattern of count copies of a group of length steps, in the order the group is repeated
+constexpr uint64_t repeatEuclideanGroup(uint64_t group, int length, int count) {
+    return count == 0 ? 0 :
+           count == 1 ? group :
+           group | repeatEuclideanGroup(group, length, count - 1) << length;
+}
+
+// Bjorklund's algorithm as written in the Grids resource script: start with one group per step,
+// the notes first, then keep appending the trailing groups to the leading ones until no trailing
+// groups are left. At every stage the groups come in two kinds, countA copies of group a followed
+// by countB copies of group b, so the state is carried in the arguments.
+constexpr uint64_t bjorklundGroups(uint64_t a, int lengthA, int countA, uint64_t b, int lengthB, int countB) {
+    return countA == 0 || countB == 0 ?
+               (countB == 0 ? repeatEuclideanGroup(a, lengthA, countA) :
+                repeatEuclideanGroup(a, lengthA, countA) | repeatEuclideanGroup(b, lengthB, countB) << (lengthA * countA)) :
+           countA <= countB ?
+               bjorklundGroups(a | b << lengthA, lengthA + lengthB, countA, b, lengthB, countB - countA) :
+               bjorklundGroups(a | b << lengthA, lengthA + lengthB, countB, a, lengthA, countA - countB);
+}
+
+constexpr uint64_t bjorklundPattern(int notes, int steps) {
+    return bjorklundGroups(1, 1, notes, 0, 1, steps - notes);
+}
+
+// Indices 0 to N - 1 as a parameter pack, halved at each level to stay within template depth limits
+template <int... Indices>
+struct EuclideanIndices {};
+
+template <typename Low, typename High>
+struct JoinEuclideanIndices;
+
+template <int... Low, int... High>
+struct JoinEuclideanIndices<EuclideanIndices<Low...>, EuclideanIndices<High...>> {
+    typedef EuclideanIndices<Low..., (static_cast<int>(sizeof...(Low)) + High)...> type;
+};
+
+template <int N>
+struct MakeEuclideanIndices {
+    typedef typename JoinEuclideanIndices<typename MakeEuclideanIndices<N / 2>::type,
+                                          typename MakeEuclideanIndices<N - N / 2>::type>::type type;
+};
+
+template <>
+struct MakeEuclideanIndices<0> {
+    typedef EuclideanIndices<> type;
+};
+
+template <>
+struct MakeEuclideanIndices<1> {
+    typedef EuclideanIndices<0> type;
+};
+
+template <int kMaxLength, typename Indices = typename MakeEuclideanIndices<kMaxLength * kEuclideanDensities>::type>
+struct EuclideanTable;
+
+template <int kMaxLength, int... Indices>
+struct EuclideanTable<kMaxLength, EuclideanIndices<Indices...>> {
+    static_assert(kMaxLength >= 1 && kMaxLength <= kMaxEuclideanLength, "Euclidean lengths go up to 64 steps");
+    typedef typename std::conditional<(kMaxLength > 32), uint64_t, uint32_t>::type Pattern;
+
+    static const int kSize = kMaxLength * kEuclideanDensities;
+    Pattern patterns[kSize];
+
+    // Entry i is length i / kEuclideanDensities + 1 at density i % kEuclideanDensities
+    constexpr EuclideanTable()
+        : patterns{static_cast<Pattern>(bjorklundPattern(
+              euclideanNotes(Indices % kEuclideanDensities, Indices / kEuclideanDensities + 1),
+              Indices / kEuclideanDensities + 1))...} {}
+
+    constexpr Pattern get(int length, int density) const {
+        return patterns[(length - 1) * kEuclideanDensities + density];
+    }
+};
+
+constexpr EuclideanTable<32> kEuclideanTable;
+
+#endif /* PhasorBeatMapEuclidean_hpp */
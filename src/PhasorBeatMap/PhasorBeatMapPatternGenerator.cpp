@@ -21,6 +21,17 @@
 //
 
 #include "PhasorBeatMapPatternGenerator.hpp"
+#include "PhasorBeatMapBarKernel.hpp"
+#include <cstring>
+
+// The generated Euclidean table has to match the one shipped with Grids bit for bit. Checked here
+// rather than in the header, so it is only evaluated once per build; the range is halved at each
+// level to stay within the constexpr depth limits.
+constexpr bool matchesGridsTable(int from, int to) {
+    return to - from == 1 ? kEuclideanTable.patterns[from] == lut_res_euclidean[from] :
+           matchesGridsTable(from, (from + to) / 2) && matchesGridsTable((from + to) / 2, to);
+}
+static_assert(matchesGridsTable(0, EuclideanTable<32>::kSize), "Euclidean table differs from lut_res_euclidean");
 
 uint8_t U8U8MulShift8(uint8_t a, uint8_t b) {
     return (a * b) >> 8;
@@ -40,6 +51,9 @@ PatternGenerator::PatternGenerator() {
     }
     _state = 0;
     _accentBits = 0;
+    _settings.barLength = 0;
+    setBarLength(kStepsPerPattern);
+    setSeed(gam::rnd::getSeed());
 }
 
 void PatternGenerator::tick(uint8_t numPulses) {
@@ -101,6 +115,51 @@ void PatternGenerator::setRandomness(float randomness) {
     _settings.randomness = static_cast<uint8_t>(randomness * 255.0);
 }
 
+void PatternGenerator::setSeed(uint32_t seed) {
+    _seed = seed;
+
+    // The first draw is linear in the state, so the seed goes through the murmur3 finalizer first:
+    // neighbouring seeds then start far apart and every seed bit counts. The multiplicative
+    // generator needs an odd state.
+    uint32_t state = seed;
+    state ^= state >> 16;
+    state *= 0x85EBCA6B;
+    state ^= state >> 13;
+    state *= 0xC2B2AE35;
+    state ^= state >> 16;
+    _random.val = state | 1;
+}
+
+uint32_t PatternGenerator::getSeed() const {
+    return _seed;
+}
+
+uint32_t PatternGenerator::getRandomState() const {
+    return _random.val;
+}
+
+void PatternGenerator::setRandomState(uint32_t state) {
+    _random.val = state | 1;
+}
+
+// One draw gives all three parts' perturbation bytes, taken from the high bits since the low
+// bits of a multiplicative congruential generator have short periods.
+void PatternGenerator::drawPerturbation(uint8_t draw[kNumParts]) {
+    const uint32_t bits = _random();
+    for (uint8_t i = 0; i < kNumParts; ++i) {
+        draw[i] = (uint8_t)(bits >> (8 + 8 * i));
+    }
+}
+
+// One draw per pass over the drum map, in order, so the first pass of a long bar gets the draw a
+// 32-step bar would
+void PatternGenerator::drawBarPerturbation(BarCache& cache) {
+    const int repeats = (_settings.barLength + kStepsPerPattern - 1) / kStepsPerPattern;
+    for (int repeat = 0; repeat < repeats; ++repeat) {
+        drawPerturbation(cache.randomDraw[repeat]);
+    }
+}
+
 void PatternGenerator::setAccentAltMode(bool accAlt){
     _settings.accAlt = accAlt;
 }
@@ -109,6 +168,25 @@ void PatternGenerator::setPatternMode(PatternGeneratorMode mode) {
     _settings.patternMode = mode;
 }
 
+void PatternGenerator::setBarLength(int length) {
+    length = std::min(std::max(length, 1), static_cast<int>(kMaxStepsPerPattern));
+    if (length == _settings.barLength) {
+        return;
+    }
+    _settings.barLength = static_cast<uint8_t>(length);
+
+    // Map position for every bar step. Shorter bars skip through the map, so no two bar steps
+    // share a map step; longer ones take their second pass one step at a time.
+    for (int step = 0; step < kMaxStepsPerPattern; ++step) {
+        int source = length <= kStepsPerPattern ? step * kStepsPerPattern / length : step;
+        _barStepSource[step] = step < length ? static_cast<uint8_t>(source) : 0;
+    }
+}
+
+uint8_t PatternGenerator::getBarLength() const {
+    return _settings.barLength;
+}
+
 uint8_t PatternGenerator::getAllStates() const {
     return _state;
 }
@@ -166,6 +244,30 @@ uint8_t PatternGenerator::readDrumMap(uint8_t step, uint8_t instrument, uint8_t
     return r;
 }
 
+// Returns the interpolated levels for every instrument and step at (x, y), filling the cache on a miss.
+const uint8_t* PatternGenerator::readDrumMapLevels(uint8_t x, uint8_t y) {
+    const uint32_t key = DrumMapCache::makeKey(x, y, _settings.patternMode);
+    DrumMapCache::Entry& entry = _drumMapCache.entries[DrumMapCache::slotForKey(key)];
+    if (entry.key != key) {
+        if (_settings.patternMode == PATTERN_HENRI) {
+            for (uint8_t i = 0; i < kNumParts; ++i) {
+                for (uint8_t step = 0; step < kStepsPerPattern; ++step) {
+                    entry.levels[i * kStepsPerPattern + step] = readDrumMap(step, i, x, y);
+                }
+            }
+        } else {
+            // Same interpolation as readDrumMap, on all instruments and steps at once
+            uint8_t i = x >> 6;
+            uint8_t j = y >> 6;
+            mixDrumMapLevels(drum_map[i][j], drum_map[i + 1][j], drum_map[i][j + 1], drum_map[i + 1][j + 1],
+                             static_cast<uint8_t>(x << 2), static_cast<uint8_t>(y << 2),
+                             entry.levels, kNumParts * kStepsPerPattern);
+        }
+        entry.key = key;
+    }
+    return entry.levels;
+}
+
 void PatternGenerator::evaluate() {
     _state = 0;
     _state |= 0x40;
@@ -198,12 +300,11 @@ void PatternGenerator::evaluateEuclidean() {
     for (uint8_t i = 0; i < kNumParts; ++i) {
         uint8_t length = (_settings.euclidean_length[i] >> 3) + 1;
         uint8_t density = _settings.density[i] >> 3;
-        uint16_t address = (length - 1) * 32 + density;
         while (_euclideanStep[i] >= length) {
             _euclideanStep[i] -= length;
         }
         uint32_t step_mask = 1L << static_cast<uint32_t>(_euclideanStep[i]);
-        uint32_t pattern_bits = *(lut_res_euclidean + address);
+        uint32_t pattern_bits = kEuclideanTable.get(length, density);
         if (pattern_bits & step_mask) {
             _state |= instrument_mask;
         }
@@ -224,10 +325,11 @@ void PatternGenerator::evaluateEuclidean() {
 void PatternGenerator::evaluateDrums() {
     // At the beginning of a pattern, decide on perturbation levels.
     if (_step == 0) {
+        uint8_t randomNum[kNumParts];
+        drawPerturbation(randomNum);
         for (uint8_t i = 0; i < kNumParts; ++i) {
-            uint8_t randomNum = (uint8_t)rand() % 256;
             uint8_t randomness = _settings.swing ? 0 : _settings.randomness >> 2;
-            _partPerturbation_[i] = U8U8MulShift8(randomNum, randomness);
+            _partPerturbation_[i] = U8U8MulShift8(randomNum[i], randomness);
         }
     }
 
@@ -265,154 +367,268 @@ void PatternGenerator::evaluateDrums() {
 
 // NEW: Generate entire bar for phasor-based playback
 void PatternGenerator::generateBar(BarCache& cache) {
-    if (_settings.patternMode == PATTERN_EUCLIDEAN) {
-        // Euclidean mode: generate all 32 steps
-        uint8_t euclideanStepLocal[kNumParts] = {0, 0, 0};
-
-        for (uint8_t step = 0; step < kStepsPerPattern; ++step) {
-            // Euclidean only evaluates on even steps (sixteenth notes)
-            if (!(step & 1)) {
-                uint8_t triggers = 0;
-                uint8_t resets = 0;
-                evaluateStepEuclidean(step, euclideanStepLocal, &triggers, &resets);
-
-                // Store trigger data
-                for (uint8_t i = 0; i < kNumParts; ++i) {
-                    cache.steps[step].trigger[i] = (triggers & (1 << i)) != 0;
-                    cache.steps[step].level[i] = cache.steps[step].trigger[i] ? 255 : 0;
-                }
-
-                // Store reset bits as accents in euclidean mode
-                if (_settings.accAlt) {
-                    // In alt mode, use common/reset bits
-                    cache.steps[step].accent[0] = (resets != 0);  // Common bit
-                    cache.steps[step].accent[1] = (resets == 0x07);  // Reset bit
-                    cache.steps[step].accent[2] = false;
-                } else {
-                    // Individual reset bits
-                    for (uint8_t i = 0; i < kNumParts; ++i) {
-                        cache.steps[step].accent[i] = (resets & (1 << i)) != 0;
-                    }
-                }
+    if (_settings.patternMode != PATTERN_EUCLIDEAN) {
+        // Drum mode: draw a new perturbation for the entire bar
+        drawBarPerturbation(cache);
+    }
+    updateBar(cache);
+}
 
-                // Increment euclidean steps for next iteration
-                for (uint8_t i = 0; i < kNumParts; ++i) {
-                    ++euclideanStepLocal[i];
-                }
-            } else {
-                // Odd steps: no triggers in Euclidean mode
-                for (uint8_t i = 0; i < kNumParts; ++i) {
-                    cache.steps[step].trigger[i] = false;
-                    cache.steps[step].accent[i] = false;
-                    cache.steps[step].level[i] = 0;
-                }
-            }
+// Rebuild the bar from the current settings, keeping the bar's perturbation draw
+void PatternGenerator::updateBar(BarCache& cache) {
+    if (_settings.patternMode == PATTERN_EUCLIDEAN) {
+        for (uint8_t i = 0; i < kNumParts; ++i) {
+            generateEuclideanPart(cache, i);
         }
+        finishEuclideanBar(cache);
     } else {
-        // Drum mode: generate perturbation for the entire bar
-        uint8_t barPerturbation[kNumParts];
+        // Map levels only depend on x, y, mode and length, so density and chaos changes skip them
+        bool levelsStale = !cache.levelsValid ||
+                           cache.levelMapX != _settings.x ||
+                           cache.levelMapY != _settings.y ||
+                           cache.levelPatternMode != _settings.patternMode ||
+                           cache.levelBarLength != _settings.barLength;
+        if (levelsStale) {
+            fillBarLevels(cache);
+        }
         for (uint8_t i = 0; i < kNumParts; ++i) {
-            uint8_t randomNum = (uint8_t)rand() % 256;
-            uint8_t randomness = _settings.swing ? 0 : _settings.randomness >> 2;
-            barPerturbation[i] = U8U8MulShift8(randomNum, randomness);
+            thresholdPart(cache, i);
         }
+    }
+
+    recordBarSettings(cache);
+    cache.staleSteps = 0;
+    cache.needsRegeneration = false;
+    ++cache.generation;
+}
+
+// Resumable updateBar(): rebuilds steps [from, from + count) of the bar from the current settings,
+// keeping its perturbation draw. The first call with settings the bar was not built with marks every
+// step stale; the bar is consistent again, and its generation moves on, once none are left.
+//
+// Drum bars are rebuilt whole on that first call instead. Their map interpolation covers every step
+// at once and the threshold kernel does a whole pass in about the time of a few scalar steps, so a
+// step range costs as much as updateBar(), which also skips the levels on density and chaos changes.
+void PatternGenerator::generateSteps(BarCache& cache, int from, int count) {
+    if (_settings.patternMode != PATTERN_EUCLIDEAN) {
+        if (barSettingsChanged(cache) || cache.staleSteps != 0) {
+            updateBar(cache);
+        }
+        return;
+    }
 
-        // Generate all 32 steps with the same perturbation
-        for (uint8_t step = 0; step < kStepsPerPattern; ++step) {
-            uint8_t triggers = 0;
-            uint8_t accents = 0;
-            uint8_t levels[kNumParts];
+    if (barSettingsChanged(cache)) {
+        recordBarSettings(cache);
+        cache.staleSteps = barStepMask();
+    }
 
-            evaluateStepDrums(step, &triggers, &accents, levels, barPerturbation);
+    const uint64_t range = (count >= kMaxStepsPerPattern ? ~0ull : (1ull << count) - 1) << from;
+    generateEuclideanSteps(cache, range);
 
-            // Store data in cache
-            for (uint8_t i = 0; i < kNumParts; ++i) {
-                cache.steps[step].trigger[i] = (triggers & (1 << i)) != 0;
-                cache.steps[step].accent[i] = (accents & (1 << i)) != 0;
-                cache.steps[step].level[i] = levels[i];
-            }
+    if (cache.staleSteps != 0) {
+        cache.staleSteps &= ~range;
+        if (cache.staleSteps == 0) {
+            cache.needsRegeneration = false;
+            ++cache.generation;
         }
     }
+}
+
+// Same bar as generateBar(), built one stage per call
+void PatternGenerator::beginBar(BarCache& cache) {
+    if (_settings.patternMode != PATTERN_EUCLIDEAN) {
+        drawBarPerturbation(cache);
+    }
+    cache.levelsValid = false;
+    cache.staleSteps = 0;
+    recordBarSettings(cache);
+}
+
+void PatternGenerator::generateBarPart(BarCache& cache, uint8_t part) {
+    if (_settings.patternMode == PATTERN_EUCLIDEAN) {
+        generateEuclideanPart(cache, part);
+    } else {
+        fillPartLevels(cache, part, readDrumMapLevels(_settings.x, _settings.y), 0, _settings.barLength);
+        thresholdPart(cache, part);
+    }
+}
+
+void PatternGenerator::finishBar(BarCache& cache) {
+    if (_settings.patternMode == PATTERN_EUCLIDEAN) {
+        finishEuclideanBar(cache);
+    } else {
+        cache.levelsValid = true;
+        cache.levelMapX = _settings.x;
+        cache.levelMapY = _settings.y;
+        cache.levelPatternMode = _settings.patternMode;
+        cache.levelBarLength = _settings.barLength;
+    }
+    cache.needsRegeneration = false;
+    ++cache.generation;
+}
+
+bool PatternGenerator::barSettingsChanged(const BarCache& cache) const {
+    bool changed = cache.lastMapX != _settings.x ||
+                   cache.lastMapY != _settings.y ||
+                   cache.lastRandomness != _settings.randomness ||
+                   cache.lastPatternMode != _settings.patternMode ||
+                   cache.lastBarLength != _settings.barLength;
+    for (uint8_t i = 0; i < kNumParts; ++i) {
+        changed |= cache.lastDensity[i] != _settings.density[i] ||
+                    cache.lastEuclideanLength[i] != _settings.euclidean_length[i];
+    }
+    return changed;
+}
 
-    // Update metadata
+void PatternGenerator::recordBarSettings(BarCache& cache) {
     cache.lastMapX = _settings.x;
     cache.lastMapY = _settings.y;
     cache.lastRandomness = _settings.randomness;
     cache.lastPatternMode = _settings.patternMode;
+    cache.lastBarLength = _settings.barLength;
     for (uint8_t i = 0; i < kNumParts; ++i) {
         cache.lastDensity[i] = _settings.density[i];
         cache.lastEuclideanLength[i] = _settings.euclidean_length[i];
     }
-    cache.needsRegeneration = false;
 }
 
-// NEW: Evaluate a single step for drum mode
-void PatternGenerator::evaluateStepDrums(uint8_t step, uint8_t* outTriggers, uint8_t* outAccents,
-                                         uint8_t* outLevels, const uint8_t* perturbation) {
-    uint8_t instrument_mask = 1;
-    uint8_t x = _settings.x;
-    uint8_t y = _settings.y;
-    uint8_t triggers = 0;
-    uint8_t accents = 0;
-
-    for (uint8_t i = 0; i < kNumParts; ++i) {
-        uint8_t level = readDrumMap(step, i, x, y);
+// Bit i set for every step i of the bar
+uint64_t PatternGenerator::barStepMask() const {
+    return _settings.barLength >= kMaxStepsPerPattern ? ~0ull : (1ull << _settings.barLength) - 1;
+}
 
-        // Apply perturbation
-        if (level < 255 - perturbation[i]) {
-            level += perturbation[i];
-        } else {
-            level = 255;
+// Euclidean mode: one part's trigger and reset bits over the bar. Patterns only advance on even
+// map positions (sixteenth notes), which the bar steps are laid out on like the drum map.
+void PatternGenerator::evaluateEuclideanPart(uint8_t part, uint64_t* triggerBits, uint64_t* resetBits) const {
+    uint8_t length = (_settings.euclidean_length[part] >> 3) + 1;
+    uint8_t density = _settings.density[part] >> 3;
+    uint32_t patternBits = kEuclideanTable.get(length, density);
+
+    uint64_t triggers = 0;
+    uint64_t resets = 0;
+    for (uint8_t step = 0; step < _settings.barLength; ++step) {
+        const uint8_t source = _barStepSource[step];
+        if (source & 1) {
+            continue;
         }
+        const uint8_t euclideanStep = (source >> 1) % length;
+        triggers |= static_cast<uint64_t>((patternBits >> euclideanStep) & 1) << step;
+        resets |= static_cast<uint64_t>(euclideanStep == 0) << step;
+    }
 
-        outLevels[i] = level;
+    *triggerBits = triggers;
+    *resetBits = resets;
+}
 
-        // Check against density threshold
-        uint8_t threshold = ~_settings.density[i];
-        if (level > threshold) {
-            triggers |= instrument_mask;
-            if (level > 192) {
-                accents |= instrument_mask;
-            }
-        }
-        instrument_mask <<= 1;
+// Reset bits are stored as accents: per part, or in alt mode the common and all-parts reset bits
+void PatternGenerator::euclideanAccents(uint64_t accents[kNumParts]) const {
+    if (_settings.accAlt) {
+        uint64_t anyReset = accents[0] | accents[1] | accents[2];
+        uint64_t allReset = accents[0] & accents[1] & accents[2];
+        accents[0] = anyReset;
+        accents[1] = allReset;
+        accents[2] = 0;
     }
+}
 
-    *outTriggers = triggers;
-    *outAccents = accents;
+void PatternGenerator::generateEuclideanPart(BarCache& cache, uint8_t part) {
+    evaluateEuclideanPart(part, &cache.triggerMask[part], &cache.accentMask[part]);
+    for (uint8_t step = 0; step < kMaxStepsPerPattern; ++step) {
+        cache.levels[part * kMaxStepsPerPattern + step] = ((cache.triggerMask[part] >> step) & 1) ? 255 : 0;
+    }
 }
 
-// NEW: Evaluate a single step for euclidean mode
-void PatternGenerator::evaluateStepEuclidean(uint8_t step, uint8_t euclideanStep[kNumParts],
-                                             uint8_t* outTriggers, uint8_t* outResets) {
-    uint8_t instrument_mask = 1;
-    uint8_t triggers = 0;
-    uint8_t resets = 0;
+void PatternGenerator::finishEuclideanBar(BarCache& cache) {
+    euclideanAccents(cache.accentMask);
 
+    // The euclidean levels overwrite the drum map layer
+    cache.levelsValid = false;
+}
+
+// Euclidean steps in range (bit i = step i). The pattern position of a bar step is just
+// (source / 2) % length for the even map position it starts, so each step is built on its own.
+void PatternGenerator::generateEuclideanSteps(BarCache& cache, uint64_t range) {
+    uint8_t length[kNumParts];
+    uint32_t patternBits[kNumParts];
     for (uint8_t i = 0; i < kNumParts; ++i) {
-        uint8_t length = (_settings.euclidean_length[i] >> 3) + 1;
-        uint8_t density = _settings.density[i] >> 3;
-        uint16_t address = (length - 1) * 32 + density;
+        length[i] = (_settings.euclidean_length[i] >> 3) + 1;
+        patternBits[i] = kEuclideanTable.get(length[i], _settings.density[i] >> 3);
+        cache.triggerMask[i] &= ~range;
+        cache.accentMask[i] &= ~range;
+    }
 
-        // Wrap euclidean step
-        while (euclideanStep[i] >= length) {
-            euclideanStep[i] -= length;
+    for (uint8_t step = 0; step < kMaxStepsPerPattern; ++step) {
+        if (!((range >> step) & 1)) {
+            continue;
         }
 
-        uint32_t step_mask = 1L << static_cast<uint32_t>(euclideanStep[i]);
-        uint32_t pattern_bits = *(lut_res_euclidean + address);
-
-        if (pattern_bits & step_mask) {
-            triggers |= instrument_mask;
+        uint64_t triggers[kNumParts] = {0, 0, 0};
+        uint64_t accents[kNumParts] = {0, 0, 0};
+        const uint8_t source = _barStepSource[step];
+        if (!(source & 1)) {
+            for (uint8_t i = 0; i < kNumParts; ++i) {
+                const uint8_t euclideanStep = (source >> 1) % length[i];
+                triggers[i] = (patternBits[i] >> euclideanStep) & 1;
+                accents[i] = euclideanStep == 0;
+            }
+            euclideanAccents(accents);
         }
-        if (euclideanStep[i] == 0) {
-            resets |= instrument_mask;
+
+        for (uint8_t i = 0; i < kNumParts; ++i) {
+            cache.triggerMask[i] |= triggers[i] << step;
+            cache.accentMask[i] |= accents[i] << step;
+            cache.levels[i * kMaxStepsPerPattern + step] = triggers[i] ? 255 : 0;
         }
+    }
+    cache.levelsValid = false;
+}
 
-        instrument_mask <<= 1;
+// Level stage: resample the interpolated drum map for the current position into the bar
+void PatternGenerator::fillBarLevels(BarCache& cache) {
+    const uint8_t* mapLevels = readDrumMapLevels(_settings.x, _settings.y);
+    for (uint8_t i = 0; i < kNumParts; ++i) {
+        fillPartLevels(cache, i, mapLevels, 0, kMaxStepsPerPattern);
     }
+    cache.levelsValid = true;
+    cache.levelMapX = _settings.x;
+    cache.levelMapY = _settings.y;
+    cache.levelPatternMode = _settings.patternMode;
+    cache.levelBarLength = _settings.barLength;
+}
 
-    *outTriggers = triggers;
-    *outResets = resets;
+// Bar steps [from, from + count) of one part. Steps past the end of the bar are silent.
+void PatternGenerator::fillPartLevels(BarCache& cache, uint8_t part, const uint8_t* mapLevels, int from, int count) {
+    const uint8_t* partLevels = mapLevels + part * kStepsPerPattern;
+    uint8_t* barLevels = cache.levels + part * kMaxStepsPerPattern;
+    if (_settings.barLength == kStepsPerPattern && from + count <= kStepsPerPattern) {
+        std::memcpy(barLevels + from, partLevels + from, count);
+        return;
+    }
+    for (int step = from; step < from + count; ++step) {
+        barLevels[step] = step < _settings.barLength ? partLevels[_barStepSource[step] % kStepsPerPattern] : 0;
+    }
 }
 
+// Threshold stage: apply each pass's perturbation and the part's density threshold to its stored
+// levels, one pass (32 steps) at a time. The kernel works on whole passes, so the steps past the end
+// of the bar are masked off.
+void PatternGenerator::thresholdPart(BarCache& cache, uint8_t part) {
+    static_assert(kBarKernelBlock == kStepsPerPattern, "Kernel blocks have to line up with the passes");
+    uint8_t randomness = _settings.swing ? 0 : _settings.randomness >> 2;
+
+    uint64_t triggers = 0;
+    uint64_t accents = 0;
+    for (int block = 0; block < _settings.barLength; block += kBarKernelBlock) {
+        const int repeat = block / kStepsPerPattern;
+        cache.perturbation[repeat][part] = U8U8MulShift8(cache.randomDraw[repeat][part], randomness);
+
+        uint32_t blockTriggers = 0;
+        uint32_t blockAccents = 0;
+        thresholdDrumLevels(cache.levels + part * kMaxStepsPerPattern + block, cache.perturbation[repeat][part],
+                            ~_settings.density[part], &blockTriggers, &blockAccents);
+        triggers |= static_cast<uint64_t>(blockTriggers) << block;
+        accents |= static_cast<uint64_t>(blockAccents) << block;
+    }
+    cache.triggerMask[part] = triggers & barStepMask();
+    cache.accentMask[part] = accents & barStepMask();
+}
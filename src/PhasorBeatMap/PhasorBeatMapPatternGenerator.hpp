@@ -34,12 +34,17 @@
 
 #include <cstdlib>
 #include <cmath>
+#include "Gamma/rnd.h"
 #include "PhasorBeatMapResources.hpp"
+#include "PhasorBeatMapEuclidean.hpp"
 
 const uint8_t kNumParts = 3;
 const uint8_t kPulsesPerStep = 3;  // 24 ppqn ; 8 steps per quarter note.
-const uint8_t kStepsPerPattern = 32;
+const uint8_t kStepsPerPattern = 32;  // Steps in the drum map
+const uint8_t kMaxStepsPerPattern = 64;  // Longest bar, two passes over the drum map
+const uint8_t kMaxBarRepeats = kMaxStepsPerPattern / kStepsPerPattern;
 const uint8_t kPulseDuration = 8;  // 8 ticks of the main clock.
+const uint8_t kDrumMapCacheSize = 64;  // Must be a power of two.
 
 uint8_t U8U8MulShift8(uint8_t a, uint8_t b);
 uint8_t U8Mix(uint8_t a, uint8_t b, uint8_t balance);
@@ -74,42 +79,110 @@ const uint8_t ticks_granularity[] = { 6, 3, 1 };
 
 // Bar cache for phasor-based playback
 struct BarCache {
-    struct StepData {
-        bool trigger[kNumParts];      // BD, SD, HH trigger states
-        bool accent[kNumParts];       // Accent flags for each channel
-        uint8_t level[kNumParts];     // Original probability level (0-255) for debugging/visualization
-
-        StepData() {
-            for (int i = 0; i < kNumParts; ++i) {
-                trigger[i] = false;
-                accent[i] = false;
-                level[i] = 0;
-            }
-        }
-    };
+    // BD, SD, HH trigger and accent states, bit i being step i. Euclidean mode stores its reset bits as accents.
+    uint64_t triggerMask[kNumParts];
+    uint64_t accentMask[kNumParts];
+
+    // Drum map level (0-255) before perturbation, laid out to the bar length as
+    // instrument * kMaxStepsPerPattern + step. Reused when only the thresholds change.
+    uint8_t levels[kNumParts * kMaxStepsPerPattern];
 
-    StepData steps[kStepsPerPattern];
+    // Perturbation applied to the steps of each pass over the drum map (steps 0-31, 32-63).
+    // randomDraw is only redrawn by generateBar(), so density and chaos amount changes re-threshold
+    // against the same draw.
+    uint8_t randomDraw[kMaxBarRepeats][kNumParts];
+    uint8_t perturbation[kMaxBarRepeats][kNumParts];
+
+    // Key for the level layer, which only depends on x, y, mode and bar length
+    bool levelsValid;
+    uint8_t levelMapX;
+    uint8_t levelMapY;
+    PatternGeneratorMode levelPatternMode;
+    uint8_t levelBarLength;
+
+    // Steps not yet rebuilt since generateSteps() saw new settings (bit i = step i)
+    uint64_t staleSteps;
 
     // Metadata for regeneration detection
     bool needsRegeneration;
+    uint32_t generation;              // Incremented every time the bar is rewritten
     uint8_t lastMapX;
     uint8_t lastMapY;
     uint8_t lastDensity[kNumParts];
     uint8_t lastRandomness;
     PatternGeneratorMode lastPatternMode;
     uint8_t lastEuclideanLength[kNumParts];
+    uint8_t lastBarLength;
 
     BarCache() {
+        levelsValid = false;
+        levelMapX = 0;
+        levelMapY = 0;
+        levelPatternMode = PATTERN_HENRI;
+        levelBarLength = kStepsPerPattern;
+        staleSteps = 0;
         needsRegeneration = true;
+        generation = 0;
         lastMapX = 0;
         lastMapY = 0;
         lastRandomness = 0;
         lastPatternMode = PATTERN_HENRI;
+        lastBarLength = kStepsPerPattern;
+        for (int i = 0; i < kNumParts * kMaxStepsPerPattern; ++i) {
+            levels[i] = 0;
+        }
         for (int i = 0; i < kNumParts; ++i) {
+            triggerMask[i] = 0;
+            accentMask[i] = 0;
+            for (int repeat = 0; repeat < kMaxBarRepeats; ++repeat) {
+                randomDraw[repeat][i] = 0;
+                perturbation[repeat][i] = 0;
+            }
             lastDensity[i] = 0;
             lastEuclideanLength[i] = 255;
         }
     }
+
+    bool getTrigger(int step, int part) const {
+        return (triggerMask[part] >> step) & 1;
+    }
+
+    bool getAccent(int step, int part) const {
+        return (accentMask[part] >> step) & 1;
+    }
+};
+
+// Lazily filled cache of interpolated drum map levels, one 96-byte vector (laid out like the
+// node tables, instrument * kStepsPerPattern + step) per (x, y, mode). Direct-mapped, so a CV
+// sweep over nearby map positions turns into lookups instead of re-interpolating every cell.
+struct DrumMapCache {
+    struct Entry {
+        uint32_t key;
+        uint8_t levels[kNumParts * kStepsPerPattern];
+    };
+
+    Entry entries[kDrumMapCacheSize];
+
+    DrumMapCache() {
+        clear();
+    }
+
+    void clear() {
+        for (int i = 0; i < kDrumMapCacheSize; ++i) {
+            entries[i].key = kInvalidKey;
+        }
+    }
+
+    static uint32_t makeKey(uint8_t x, uint8_t y, PatternGeneratorMode mode) {
+        return (static_cast<uint32_t>(mode) << 16) | (static_cast<uint32_t>(x) << 8) | y;
+    }
+
+    // Neighbouring x positions land in neighbouring slots.
+    static uint8_t slotForKey(uint32_t key) {
+        return ((key & 0xFF) * 7 + (key >> 8)) & (kDrumMapCacheSize - 1);
+    }
+
+    static const uint32_t kInvalidKey = 0xFFFFFFFF;
 };
 
 struct PatternGeneratorOptions {
@@ -122,6 +195,7 @@ struct PatternGeneratorOptions {
             density[i] = 0;
         }
         patternMode = PATTERN_HENRI;
+        barLength = kStepsPerPattern;
         swing = false;
         accAlt = false;
     }
@@ -131,6 +205,7 @@ struct PatternGeneratorOptions {
     uint8_t euclidean_length[kNumParts];
     uint8_t density[kNumParts];
     PatternGeneratorMode patternMode;
+    uint8_t barLength;
     bool accAlt;
     bool swing;
 };
@@ -151,6 +226,23 @@ public:
     void setAccentAltMode(bool accAlt);
     void setPatternMode(PatternGeneratorMode mode);
 
+    // Steps in the bars built by generateBar() and friends, 1 to kMaxStepsPerPattern. Up to
+    // kStepsPerPattern steps, bar step s plays drum map step s * kStepsPerPattern / length, so
+    // shorter bars skip through the map and every bar step can trigger. Longer bars play the whole
+    // map, then a second pass over it from bar step kStepsPerPattern on, with a chaos draw of its
+    // own: a 48-step bar is a 32-step bar followed by the first half of another, and a 64-step bar
+    // is a two-bar phrase. Euclidean patterns carry on through the second pass instead of restarting.
+    void setBarLength(int length);
+    uint8_t getBarLength() const;
+
+    // Chaos perturbations come from a per-instance generator, so a seed replays the same bars
+    void setSeed(uint32_t seed);
+    uint32_t getSeed() const;
+
+    // The generator's place in its random stream, for callers that keep one stream per voice
+    uint32_t getRandomState() const;
+    void setRandomState(uint32_t state);
+
     uint8_t getAllStates() const;
     uint8_t getDrumState(uint8_t channel) const;
     PatternGeneratorMode getPatternMode() const;
@@ -158,7 +250,22 @@ public:
     uint8_t getEuclideanLength(uint8_t channel);
 
     // NEW: Bar generation for phasor-based playback
+    // generateBar() draws a new chaos perturbation for the bar; updateBar() keeps the current one
+    // and only redoes the stages whose inputs changed (map levels on x/y/mode, thresholds always).
     void generateBar(BarCache& cache);
+    void updateBar(BarCache& cache);
+
+    // Resumable updateBar(), rebuilding steps [from, from + count) of the bar; see BarCache::staleSteps.
+    // The range must lie within the bar. Only Euclidean bars are built a range at a time; drum bars
+    // are rebuilt whole, as a range would cost about as much.
+    void generateSteps(BarCache& cache, int from, int count);
+
+    // Resumable generateBar(), for spreading a bar over several calls: beginBar() draws the
+    // perturbation, generateBarPart() builds one part, finishBar() marks the bar as built.
+    // The settings must stay the same from beginBar() to finishBar().
+    void beginBar(BarCache& cache);
+    void generateBarPart(BarCache& cache, uint8_t part);
+    void finishBar(BarCache& cache);
 
 private:
     PatternGeneratorOptions _settings;
@@ -171,14 +278,30 @@ private:
     uint8_t _accentBits;
 
     uint8_t _partPerturbation_[kNumParts];
+    uint8_t _barStepSource[kMaxStepsPerPattern];  // Map position, counting on through a second pass
+    uint32_t _seed;
+    gam::RNGMulCon _random;
+    void drawPerturbation(uint8_t draw[kNumParts]);
+    void drawBarPerturbation(BarCache& cache);
+    DrumMapCache _drumMapCache;
     uint8_t readDrumMap(uint8_t step, uint8_t instrument, uint8_t x, uint8_t y);
+    const uint8_t* readDrumMapLevels(uint8_t x, uint8_t y);
     void evaluate();
     void evaluateEuclidean();
     void evaluateDrums();
 
     // NEW: Step-by-step evaluation for bar generation
-    void evaluateStepDrums(uint8_t step, uint8_t* outTriggers, uint8_t* outAccents, uint8_t* outLevels, const uint8_t* perturbation);
-    void evaluateStepEuclidean(uint8_t step, uint8_t euclideanStep[kNumParts], uint8_t* outTriggers, uint8_t* outResets);
+    bool barSettingsChanged(const BarCache& cache) const;
+    void recordBarSettings(BarCache& cache);
+    uint64_t barStepMask() const;
+    void evaluateEuclideanPart(uint8_t part, uint64_t* triggerBits, uint64_t* resetBits) const;
+    void euclideanAccents(uint64_t accents[kNumParts]) const;
+    void generateEuclideanPart(BarCache& cache, uint8_t part);
+    void finishEuclideanBar(BarCache& cache);
+    void generateEuclideanSteps(BarCache& cache, uint64_t range);
+    void fillBarLevels(BarCache& cache);
+    void fillPartLevels(BarCache& cache, uint8_t part, const uint8_t* mapLevels, int from, int count);
+    void thresholdPart(BarCache& cache, uint8_t part);
 };
 
 #endif /* PhasorBeatMapPatternGenerator_hpp */
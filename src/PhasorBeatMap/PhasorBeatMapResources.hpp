@@ -25,7 +25,9 @@
 
 #include <cstdint>
 
-const uint32_t lut_res_euclidean[] = {
+// Euclidean patterns as shipped with Grids. Only kept as the reference the generated tables in
+// PhasorBeatMapEuclidean.hpp are checked against at compile time, in PhasorBeatMapPatternGenerator.cpp.
+constexpr uint32_t lut_res_euclidean[] = {
     0,      0,      0,      0,      0,      0,      0,      0,
     0,      0,      0,      0,      0,      0,      0,      0,
     1,      1,      1,      1,      1,      1,      1,      1,
@@ -0,0 +1,52 @@
+//
+// PhasorBeatMapScheduler.hpp
+// Process-wide staggering of pattern work between PhasorBeatMap instances.
+//
+// This source code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Instances driven by the same phasor reach their bar boundaries on the same sample, and a
+// loaded patch starts all of them in the same block. Instead of generating every bar at that
+// moment, each instance takes a ticket when it is created and each of its lanes waits for its own
+// slot before doing deferred pattern work. Consecutive instances and lanes land in consecutive
+// slots, so the work of a whole patch is spread over kSlots * kSlotFrames frames.
+
+#ifndef PhasorBeatMapScheduler_hpp
+#define PhasorBeatMapScheduler_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+class BarScheduler {
+public:
+    static const int kSlots = 64;
+    static const int kSlotFrames = 64;
+
+    static uint32_t takeTicket() {
+        static std::atomic<uint32_t> nextTicket{0};
+        return nextTicket.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Frames a lane waits, from the moment its work becomes due, before doing it
+    static int slotDelay(uint32_t ticket, int lane) {
+        return static_cast<int>((ticket + static_cast<uint32_t>(lane)) % kSlots) * kSlotFrames;
+    }
+
+    // Same, for work with a deadline: the wait is cut short to at most maxFrames
+    static int slotDelay(uint32_t ticket, int lane, uint32_t maxFrames) {
+        return static_cast<int>(std::min(static_cast<uint32_t>(slotDelay(ticket, lane)), maxFrames));
+    }
+};
+
+#endif /* PhasorBeatMapScheduler_hpp */
@@ -0,0 +1,90 @@
+//
+// PhasorBeatMapSnapshot.hpp
+// Pattern snapshots published from the engine thread to the panel display.
+//
+// This source code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// A triple buffer hands whole snapshots across threads without locks: the writer fills its own
+// back buffer and swaps it with the shared middle one, the reader swaps its front buffer with the
+// middle one when a fresh value is waiting. Neither side ever waits on the other or allocates, and
+// neither can see a buffer the other is still writing.
+
+#ifndef PhasorBeatMapSnapshot_hpp
+#define PhasorBeatMapSnapshot_hpp
+
+#include <atomic>
+#include <cstdint>
+#include "PhasorBeatMapPatternGenerator.hpp"
+
+// What the panel needs to draw the bar of the first channel
+struct BarSnapshot {
+    uint64_t triggerMask[kNumParts];
+    uint64_t accentMask[kNumParts];
+    uint32_t generation;
+    int length;
+    int step;
+    float fractionalStep;
+
+    BarSnapshot() {
+        for (int i = 0; i < kNumParts; ++i) {
+            triggerMask[i] = 0;
+            accentMask[i] = 0;
+        }
+        generation = 0;
+        length = kStepsPerPattern;
+        step = 0;
+        fractionalStep = 0.0f;
+    }
+};
+
+// Single writer, single reader
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer: fill back(), then publish() it
+    T& back() {
+        return _buffers[_backIndex];
+    }
+
+    void publish() {
+        const uint8_t previous = _middle.exchange(_backIndex | kFreshBit, std::memory_order_acq_rel);
+        _backIndex = previous & kIndexMask;
+    }
+
+    // Reader: fetch() takes the latest published value, if there is one, into front().
+    // Returns true when front() changed.
+    bool fetch() {
+        if (!(_middle.load(std::memory_order_relaxed) & kFreshBit)) {
+            return false;
+        }
+        const uint8_t previous = _middle.exchange(_frontIndex, std::memory_order_acq_rel);
+        _frontIndex = previous & kIndexMask;
+        return true;
+    }
+
+    const T& front() const {
+        return _buffers[_frontIndex];
+    }
+
+private:
+    static const uint8_t kIndexMask = 0x03;
+    static const uint8_t kFreshBit = 0x04;
+
+    T _buffers[3];
+    uint8_t _backIndex = 0;
+    uint8_t _frontIndex = 1;
+    std::atomic<uint8_t> _middle{2};
+};
+
+#endif /* PhasorBeatMapSnapshot_hpp */
@@ -3,221 +3,220 @@
 
 #include "ValleyWidgets.hpp"
 
+// A knob type's SVGs, loaded the first time the type is constructed and shared by all instances
+struct RoganSvgSet {
+    std::shared_ptr<window::Svg> base;
+    std::shared_ptr<window::Svg> bg;
+    std::shared_ptr<window::Svg> fg;
+
+    RoganSvgSet(const char* basePath, const char* bgPath = nullptr, const char* fgPath = nullptr) {
+        base = Svg::load(asset::plugin(pluginInstance, basePath));
+        if (bgPath) bg = Svg::load(asset::plugin(pluginInstance, bgPath));
+        if (fgPath) fg = Svg::load(asset::plugin(pluginInstance, fgPath));
+    }
+
+    void applyTo(Rogan* knob) const {
+        knob->setSvg(base);
+        if (bg) knob->bg->setSvg(bg);
+        if (fg) knob->fg->setSvg(fg);
+    }
+};
+
 struct Rogan1PSBrightRed : Rogan {
     Rogan1PSBrightRed() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Rogan1PSBrightRed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Rogan1PS-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Rogan1PSBrightRed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Rogan1PSBrightRed.svg", "res/v2/Rogan1PS-bg.svg", "res/v2/Rogan1PSBrightRed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganSmallBrightRed : Rogan {
     RoganSmallBrightRed() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSBrightRedSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSBrightRedSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Small/Rogan1PSBrightRedSmall.svg", "res/v2/Small/Rogan1PSSmall-bg.svg", "res/v2/Small/Rogan1PSBrightRedSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct Rogan1PSYellow : Rogan {
     Rogan1PSYellow() {
-        setSvg(APP->window->loadSvg(asset::plugin(pluginInstance, "res/v2/Rogan1PSYellow.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Rogan1PS-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Rogan1PSYellow-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Rogan1PSYellow.svg", "res/v2/Rogan1PS-bg.svg", "res/v2/Rogan1PSYellow-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganSmallYellow : Rogan {
     RoganSmallYellow() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSYellowSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSYellowSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Small/Rogan1PSYellowSmall.svg", "res/v2/Small/Rogan1PSSmall-bg.svg", "res/v2/Small/Rogan1PSYellowSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedWhite : Rogan {
     RoganMedWhite() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSWhiteMed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMed-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSWhiteMed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSWhiteMed.svg", "res/v2/Med/Rogan1PSMed-bg.svg", "res/v2/Med/Rogan1PSWhiteMed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedSmallWhite : Rogan {
     RoganMedSmallWhite() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSWhiteMedSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMedSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSWhiteMedSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSWhiteMedSmall.svg", "res/v2/Med/Rogan1PSMedSmall-bg.svg", "res/v2/Med/Rogan1PSWhiteMedSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganSmallWhite : Rogan {
     RoganSmallWhite() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSWhiteSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSWhiteSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Small/Rogan1PSWhiteSmall.svg", "res/v2/Small/Rogan1PSSmall-bg.svg", "res/v2/Small/Rogan1PSWhiteSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedGreen : Rogan {
     RoganMedGreen() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSGreenMed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMed-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSGreenMed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSGreenMed.svg", "res/v2/Med/Rogan1PSMed-bg.svg", "res/v2/Med/Rogan1PSGreenMed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedGreenWithModeText : ValleyRogan {
     RoganMedGreenWithModeText() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSGreenMed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMed-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSGreenMed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSGreenMed.svg", "res/v2/Med/Rogan1PSMed-bg.svg", "res/v2/Med/Rogan1PSGreenMed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganSmallGreen : Rogan {
     RoganSmallGreen() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSGreenSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSGreenSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Small/Rogan1PSGreenSmall.svg", "res/v2/Small/Rogan1PSSmall-bg.svg", "res/v2/Small/Rogan1PSGreenSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedBlue : Rogan {
     RoganMedBlue() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSBlueMed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMed-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSBlueMed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSBlueMed.svg", "res/v2/Med/Rogan1PSMed-bg.svg", "res/v2/Med/Rogan1PSBlueMed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedSmallBlue : Rogan {
     RoganMedSmallBlue() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSBlueMedSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMedSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSBlueMedSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSBlueMedSmall.svg", "res/v2/Med/Rogan1PSMedSmall-bg.svg", "res/v2/Med/Rogan1PSBlueMedSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedBlueSnap : Rogan {
     RoganMedBlueSnap() {
-        setSvg(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Rogan1PSBlueMed.svg")));
+        static const RoganSvgSet svgs("res/Rogan1PSBlueMed.svg");
+        svgs.applyTo(this);
         snap = true;
     }
 };
 
 struct RoganMedSmallBlueSnap : Rogan {
     RoganMedSmallBlueSnap() {
-        setSvg(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Rogan1PSBlueMedSmall.svg")));
+        static const RoganSvgSet svgs("res/Rogan1PSBlueMedSmall.svg");
+        svgs.applyTo(this);
         snap = true;
     }
 };
 
 struct RoganSmallBlue : Rogan {
     RoganSmallBlue() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSBlueSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSBlueSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Small/Rogan1PSBlueSmall.svg", "res/v2/Small/Rogan1PSSmall-bg.svg", "res/v2/Small/Rogan1PSBlueSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedRed : Rogan {
     RoganMedRed() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSRedMed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMed-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSRedMed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSRedMed.svg", "res/v2/Med/Rogan1PSMed-bg.svg", "res/v2/Med/Rogan1PSRedMed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedRedWithModeText : ValleyRogan {
     RoganMedRedWithModeText() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSRedMed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMed-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSRedMed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSRedMed.svg", "res/v2/Med/Rogan1PSMed-bg.svg", "res/v2/Med/Rogan1PSRedMed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganSmallRed : Rogan {
     RoganSmallRed() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSRedSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSRedSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Small/Rogan1PSRedSmall.svg", "res/v2/Small/Rogan1PSSmall-bg.svg", "res/v2/Small/Rogan1PSRedSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct Rogan1PSPurple : Rogan {
     Rogan1PSPurple() {
-        setSvg(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Rogan1PSPurple.svg")));
+        static const RoganSvgSet svgs("res/Rogan1PSPurple.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedPurple : Rogan {
     RoganMedPurple() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSPurpleMed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMed-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSPurpleMed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSPurpleMed.svg", "res/v2/Med/Rogan1PSMed-bg.svg", "res/v2/Med/Rogan1PSPurpleMed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedPurpleWithModeText : ValleyRogan {
     RoganMedPurpleWithModeText() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSPurpleMed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMed-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSPurpleMed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSPurpleMed.svg", "res/v2/Med/Rogan1PSMed-bg.svg", "res/v2/Med/Rogan1PSPurpleMed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganSmallPurple : Rogan {
     RoganSmallPurple() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSPurpleSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSPurpleSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Small/Rogan1PSPurpleSmall.svg", "res/v2/Small/Rogan1PSSmall-bg.svg", "res/v2/Small/Rogan1PSPurpleSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct Rogan1PSMustard : Rogan {
     Rogan1PSMustard() {
-        setSvg(APP->window->loadSvg(asset::plugin(pluginInstance, "res/Rogan1PSMustard.svg")));
+        static const RoganSvgSet svgs("res/Rogan1PSMustard.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedMustard : Rogan {
     RoganMedMustard() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMustardMed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMed-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMustardMed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSMustardMed.svg", "res/v2/Med/Rogan1PSMed-bg.svg", "res/v2/Med/Rogan1PSMustardMed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganSmallMustard : Rogan {
     RoganSmallMustard() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSMustardSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSMustardSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Small/Rogan1PSMustardSmall.svg", "res/v2/Small/Rogan1PSSmall-bg.svg", "res/v2/Small/Rogan1PSMustardSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct Rogan1PSOrange : Rogan {
     Rogan1PSOrange() {
-        setSvg(APP->window->loadSvg(asset::plugin(pluginInstance, "res/v2/Rogan1PSOrange.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Rogan1PS-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Rogan1PSOrange-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Rogan1PSOrange.svg", "res/v2/Rogan1PS-bg.svg", "res/v2/Rogan1PSOrange-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganMedOrange : Rogan {
     RoganMedOrange() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSOrangeMed.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSMed-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Med/Rogan1PSOrangeMed-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Med/Rogan1PSOrangeMed.svg", "res/v2/Med/Rogan1PSMed-bg.svg", "res/v2/Med/Rogan1PSOrangeMed-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
 struct RoganSmallOrange : Rogan {
     RoganSmallOrange() {
-        setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSOrangeSmall.svg")));
-        bg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSSmall-bg.svg")));
-        fg->setSvg(Svg::load(asset::plugin(pluginInstance, "res/v2/Small/Rogan1PSOrangeSmall-fg.svg")));
+        static const RoganSvgSet svgs("res/v2/Small/Rogan1PSOrangeSmall.svg", "res/v2/Small/Rogan1PSSmall-bg.svg", "res/v2/Small/Rogan1PSOrangeSmall-fg.svg");
+        svgs.applyTo(this);
     }
 };
 
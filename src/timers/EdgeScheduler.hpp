@@ -0,0 +1,138 @@
+//
+// EdgeScheduler.hpp
+// Pending output edges, ordered by the sample they are due on.
+//
+// This source code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// A fixed-capacity binary min-heap with one slot per output id. Scheduling an id that is already
+// pending moves its edge, so a retriggered pulse simply ends later. Times are sample counts that
+// may wrap; they are compared by signed difference, which holds while every pending edge is less
+// than 2^31 samples away. With nothing due, popDue() is a single compare.
+
+#ifndef EDGE_SCHEDULER_HPP
+#define EDGE_SCHEDULER_HPP
+
+#include <cmath>
+#include <cstdint>
+
+template <int kCapacity>
+class EdgeScheduler {
+public:
+    EdgeScheduler() {
+        clear();
+    }
+
+    void clear() {
+        _size = 0;
+        for (int id = 0; id < kCapacity; ++id) {
+            _position[id] = -1;
+        }
+    }
+
+    // Schedules the edge of output id (0 to kCapacity - 1) on sample time, replacing any pending one
+    void schedule(int id, uint32_t time) {
+        int i = _position[id];
+        if (i < 0) {
+            i = _size++;
+            _heap[i].id = id;
+            _position[id] = i;
+        }
+        _heap[i].time = time;
+        siftDown(siftUp(i));
+    }
+
+    // Removes and returns the id of an edge due at or before now, or returns -1 if none is
+    int popDue(uint32_t now) {
+        if (_size == 0 || before(now, _heap[0].time)) {
+            return -1;
+        }
+        const int id = _heap[0].id;
+        _position[id] = -1;
+        if (--_size > 0) {
+            _heap[0] = _heap[_size];
+            _position[_heap[0].id] = 0;
+            siftDown(0);
+        }
+        return id;
+    }
+
+    bool isPending(int id) const {
+        return _position[id] >= 0;
+    }
+
+    // Stretches the time left to every pending edge by ratio, e.g. on a sample rate change.
+    // Scaling every distance from now by the same factor keeps the heap ordered.
+    void rescale(uint32_t now, float ratio) {
+        for (int i = 0; i < _size; ++i) {
+            const int32_t remaining = (int32_t)(_heap[i].time - now);
+            const int32_t scaled = remaining > 0 ? (int32_t)std::lround(remaining * ratio) : remaining;
+            _heap[i].time = now + (uint32_t)scaled;
+        }
+    }
+
+private:
+    struct Edge {
+        uint32_t time;
+        int id;
+    };
+
+    Edge _heap[kCapacity];
+    int _position[kCapacity];
+    int _size;
+
+    static bool before(uint32_t a, uint32_t b) {
+        return (int32_t)(a - b) < 0;
+    }
+
+    void swap(int i, int j) {
+        const Edge edge = _heap[i];
+        _heap[i] = _heap[j];
+        _heap[j] = edge;
+        _position[_heap[i].id] = i;
+        _position[_heap[j].id] = j;
+    }
+
+    int siftUp(int i) {
+        while (i > 0) {
+            const int parent = (i - 1) / 2;
+            if (!before(_heap[i].time, _heap[parent].time)) {
+                break;
+            }
+            swap(i, parent);
+            i = parent;
+        }
+        return i;
+    }
+
+    void siftDown(int i) {
+        while (true) {
+            const int left = 2 * i + 1;
+            const int right = left + 1;
+            int earliest = i;
+            if (left < _size && before(_heap[left].time, _heap[earliest].time)) {
+                earliest = left;
+            }
+            if (right < _size && before(_heap[right].time, _heap[earliest].time)) {
+                earliest = right;
+            }
+            if (earliest == i) {
+                return;
+            }
+            swap(i, earliest);
+            i = earliest;
+        }
+    }
+};
+
+#endif // EDGE_SCHEDULER_HPP
@@ -34,39 +34,64 @@
 //
 
 #include "Oneshot.hpp"
+#include <cmath>
 
 Oneshot::Oneshot() {
     _state = 0;
     _sampleRate = 44100.0;
-    setDuration(0.100);
-    _elapsedTime = 0.0;
+    _duration = 0.100;
+    _remainingSamples = 0;
+    _triggerOffset = 0.0;
+    updateLength();
 }
 
 Oneshot::Oneshot(float duration, float sampleRate) {
     _state = 0;
     _sampleRate = sampleRate;
-    setDuration(duration);
-    _elapsedTime = 0.0;
+    _duration = duration < 0.0 ? 0.0 : duration;
+    _remainingSamples = 0;
+    _triggerOffset = 0.0;
+    updateLength();
 }
 
 void Oneshot::trigger() {
     _state = 1;
-    _elapsedTime = 0.0;
+    _remainingSamples = _lengthSamples;
+    _triggerOffset = 0.0;
+}
+
+void Oneshot::trigger(float offset) {
+    _state = 1;
+    _remainingSamples = _lengthSamples;
+    _triggerOffset = offset;
 }
 
 void Oneshot::process() {
-    if(_elapsedTime >= _duration) {
+    if(_remainingSamples > 0) {
+        --_remainingSamples;
+    }
+    else {
         _state = 0;
-        _elapsedTime = 0.0;
     }
-    if(_state == 1) {
-        _elapsedTime += _deltaTime;
+}
+
+void Oneshot::processN(int n) {
+    if(n <= _remainingSamples) {
+        _remainingSamples -= n;
+    }
+    else {
+        _remainingSamples = 0;
+        _state = 0;
     }
 }
 
 void Oneshot::setSampleRate(float sampleRate) {
+    // A running pulse keeps the same share of its time left
+    if(_state == 1 && _sampleRate > 0.0) {
+        _remainingSamples = (int)std::lround(_remainingSamples * (sampleRate / _sampleRate));
+    }
     _sampleRate = sampleRate;
-    _deltaTime = 1.0 / _sampleRate;
+    updateLength();
 }
 
 void Oneshot::setDuration(float duration) {
@@ -74,9 +99,24 @@ void Oneshot::setDuration(float duration) {
     if(_duration < 0.0) {
         _duration = 0.0;
     }
-    _deltaTime = 1.0 / _sampleRate;
+    updateLength();
 }
 
 int Oneshot::getState() const {
     return _state;
 }
+
+float Oneshot::getTriggerOffset() const {
+    return _triggerOffset;
+}
+
+int Oneshot::getLengthSamples() const {
+    return _lengthSamples;
+}
+
+void Oneshot::updateLength() {
+    _lengthSamples = (int)std::lround(_duration * _sampleRate);
+    if(_lengthSamples < 0) {
+        _lengthSamples = 0;
+    }
+}
@@ -36,22 +36,35 @@
 #ifndef VALLEY_ONESHOT_HPP
 #define VALLEY_ONESHOT_HPP
 
+// The pulse lasts duration * sampleRate samples, rounded, counting the sample it was triggered on.
+// The length is worked out whenever the duration or sample rate changes, and a running pulse
+// counts its remaining samples down, so its width is exact whatever the setter order.
 class Oneshot {
 public:
     Oneshot();
     Oneshot(float duration, float _sampleRate);
     void trigger();
+    // Trigger with the rising edge "offset" samples (0 to 1) before the current sample. A boundary
+    // less than a sample ago doesn't change the width; the offset is kept for hosts that schedule edges.
+    void trigger(float offset);
     void process();
+    // Same as n calls to process()
+    void processN(int n);
 
     void setSampleRate(float sampleRate);
     void setDuration(float duration);
     int getState() const;
+    float getTriggerOffset() const;
+    int getLengthSamples() const;
 private:
+    void updateLength();
+
     int _state;
     float _sampleRate;
     float _duration;
-    float _elapsedTime;
-    float _deltaTime;
+    int _lengthSamples;
+    int _remainingSamples;
+    float _triggerOffset;
 };
 
 #endif // VALLEY_ONESHOT_HPP
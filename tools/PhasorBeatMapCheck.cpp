@@ -0,0 +1,250 @@
+//
+// PhasorBeatMapCheck.cpp
+// Bit-exactness checks for PhasorBeatMap's whole-bar drum map path and trigger pulse timing.
+//
+// This source code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Bars from generateBar(), which go through the cached levels and the SIMD bar kernels, have to
+// match the per-step evaluation they replaced. The reference below is that evaluation as it stood
+// before the bar cache: readDrumMap() interpolating one step of the map, and evaluateDrums() adding
+// the part's chaos perturbation and comparing against the density. It is kept here verbatim, so it
+// does not share any code with the path under test. The reference uses the chaos draw generateBar()
+// took, and every trigger and accent of the 32-step bar is compared over all map positions in both
+// drum modes, for a spread of densities and chaos amounts.
+//
+// Oneshot pulses are counted in whole samples: a pulse has to last round(duration * sampleRate)
+// samples at the usual rates, processN(n) has to match n calls to process(), and a sample rate
+// change part way through a pulse has to keep the time it has left.
+//
+// Only needs the pattern generator and Oneshot, so it builds and runs without libRack. Run with
+// `make check`; results are printed as {"check":"drum_map_bars",...} and {"check":"oneshot",...},
+// and a failure exits with status 1.
+
+#include "../src/PhasorBeatMap/PhasorBeatMapPatternGenerator.hpp"
+#include "../src/timers/Oneshot.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+struct CheckSettings {
+    PatternGeneratorMode mode;
+    int x, y;
+    int density[kNumParts];
+    int chaos;
+    uint32_t seed;
+};
+
+void applySettings(PatternGenerator& generator, const CheckSettings& settings) {
+    generator.setPatternMode(settings.mode);
+    generator.setMapX(settings.x / 255.0f);
+    generator.setMapY(settings.y / 255.0f);
+    generator.setBDDensity(settings.density[0] / 255.0f);
+    generator.setSDDensity(settings.density[1] / 255.0f);
+    generator.setHHDensity(settings.density[2] / 255.0f);
+    generator.setRandomness(settings.chaos / 255.0f);
+    generator.setSeed(settings.seed);
+}
+
+// readDrumMap() before the bar cache
+uint8_t referenceDrumMap(PatternGeneratorMode mode, uint8_t step, uint8_t instrument, uint8_t x, uint8_t y) {
+    uint8_t r = 0;
+    if (mode == PATTERN_HENRI) {
+        uint8_t i = (int)floor(x * 3.0 / 255.0);
+        uint8_t j = (int)floor(y * 3.0 / 255.0);
+        const uint8_t* a_map = drum_map[i][j];
+        const uint8_t* b_map = drum_map[i + 1][j];
+        const uint8_t* c_map = drum_map[i][j + 1];
+        const uint8_t* d_map = drum_map[i + 1][j + 1];
+        uint8_t offset = (instrument * kStepsPerPattern) + step;
+        uint8_t a = a_map[offset];
+        uint8_t b = b_map[offset];
+        uint8_t c = c_map[offset];
+        uint8_t d = d_map[offset];
+        uint8_t maxValue = 127;
+        r = (( a * x + b * (maxValue - x) ) * y + (c * x + d * (maxValue - x)) *
+             ( maxValue - y )) / maxValue / maxValue;
+    }
+    else {
+        uint8_t i = x >> 6;
+        uint8_t j = y >> 6;
+        const uint8_t* a_map = drum_map[i][j];
+        const uint8_t* b_map = drum_map[i + 1][j];
+        const uint8_t* c_map = drum_map[i][j + 1];
+        const uint8_t* d_map = drum_map[i + 1][j + 1];
+        uint8_t offset = (instrument * kStepsPerPattern) + step;
+        uint8_t a = *(a_map + offset);
+        uint8_t b = *(b_map + offset);
+        uint8_t c = *(c_map + offset);
+        uint8_t d = *(d_map + offset);
+        r = U8Mix(U8Mix(a, b, x << 2), U8Mix(c, d, x << 2), y << 2);
+    }
+
+    return r;
+}
+
+// Returns the number of steps whose triggers or accents differ from the reference
+int compareBar(PatternGenerator& generator, const CheckSettings& settings) {
+    applySettings(generator, settings);
+
+    BarCache bar;
+    generator.generateBar(bar);
+
+    int mismatches = 0;
+    for (int step = 0; step < kStepsPerPattern; ++step) {
+        for (uint8_t i = 0; i < kNumParts; ++i) {
+            // evaluateDrums() before the bar cache, with the perturbation drawn for this bar
+            const uint8_t randomness = settings.chaos >> 2;
+            const uint8_t perturbation = U8U8MulShift8(bar.randomDraw[0][i], randomness);
+            uint8_t level = referenceDrumMap(settings.mode, step, i, settings.x, settings.y);
+            if (level < 255 - perturbation) {
+                level += perturbation;
+            }
+            else {
+                level = 255;
+            }
+            uint8_t threshold = ~settings.density[i];
+            const bool trigger = level > threshold;
+            const bool accent = trigger && level > 192;
+
+            if (trigger != bar.getTrigger(step, i) || accent != bar.getAccent(step, i)) {
+                ++mismatches;
+                break;
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Samples a pulse is high for, triggered and then processed once per sample like a module does
+int pulseWidth(Oneshot& oneshot) {
+    oneshot.trigger();
+    int width = 0;
+    for (oneshot.process(); oneshot.getState(); oneshot.process()) {
+        ++width;
+    }
+    return width;
+}
+
+// Returns the number of failed Oneshot checks
+int checkOneshot() {
+    const float sampleRates[] = {44100.0f, 48000.0f, 96000.0f, 192000.0f};
+    const float durations[] = {0.001f, 0.0015f, 0.01f};
+    int failures = 0;
+
+    for (float sampleRate : sampleRates) {
+        for (float duration : durations) {
+            Oneshot oneshot(duration, sampleRate);
+            const int expected = (int)std::lround(duration * sampleRate);
+            if (pulseWidth(oneshot) != expected || oneshot.getLengthSamples() != expected) {
+                std::printf("oneshot: %g s at %g Hz is %d samples wide, expected %d\n", duration, sampleRate,
+                            pulseWidth(oneshot), expected);
+                ++failures;
+            }
+
+            // processN() against the same number of process() calls, over chunk sizes that end
+            // before, on and after the pulse's last sample
+            for (int n = 1; n <= expected + 2; ++n) {
+                Oneshot chunked(duration, sampleRate);
+                Oneshot single(duration, sampleRate);
+                chunked.trigger();
+                single.trigger();
+                for (int frame = 0; frame < expected + 2 * n; frame += n) {
+                    chunked.processN(n);
+                    for (int i = 0; i < n; ++i) {
+                        single.process();
+                    }
+                    if (chunked.getState() != single.getState()) {
+                        std::printf("oneshot: processN(%d) differs %d samples into a %d sample pulse\n", n,
+                                    frame + n, expected);
+                        ++failures;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // A sample rate change part way through a pulse keeps the time it has left, to within a sample
+    // at the new rate. A change while idle only changes the next pulse's width.
+    for (float from : sampleRates) {
+        for (float to : sampleRates) {
+            const float duration = 0.001f;
+            Oneshot oneshot(duration, from);
+            oneshot.trigger();
+            const int before = (int)std::lround(duration * from) / 2;
+            for (int i = 0; i < before; ++i) {
+                oneshot.process();
+            }
+            oneshot.setSampleRate(to);
+            int after = 0;
+            for (oneshot.process(); oneshot.getState(); oneshot.process()) {
+                ++after;
+            }
+            const float elapsed = before / from + after / to;
+            if (std::fabs(elapsed - duration) > 1.0f / to) {
+                std::printf("oneshot: %g Hz to %g Hz part way through makes a %g s pulse\n", from, to, elapsed);
+                ++failures;
+            }
+            if (pulseWidth(oneshot) != (int)std::lround(duration * to)) {
+                std::printf("oneshot: the pulse after %g Hz to %g Hz is %d samples wide\n", from, to,
+                            pulseWidth(oneshot));
+                ++failures;
+            }
+        }
+    }
+    return failures;
+}
+
+} // namespace
+
+int main() {
+    const PatternGeneratorMode modes[] = {PATTERN_ORIGINAL, PATTERN_HENRI};
+    const int densities[] = {0, 64, 128, 192, 255};
+    const int chaosAmounts[] = {0, 128, 255};
+
+    PatternGenerator generator;
+    long bars = 0;
+    long mismatches = 0;
+
+    for (PatternGeneratorMode mode : modes) {
+        for (int density : densities) {
+            for (int chaos : chaosAmounts) {
+                for (int x = 0; x < 256; ++x) {
+                    for (int y = 0; y < 256; ++y) {
+                        CheckSettings settings;
+                        settings.mode = mode;
+                        settings.x = x;
+                        settings.y = y;
+                        // Different densities per part, so no part's threshold hides another's
+                        settings.density[0] = density;
+                        settings.density[1] = 255 - density;
+                        settings.density[2] = (density + 128) & 0xFF;
+                        settings.chaos = chaos;
+                        settings.seed = (uint32_t)(x << 8 | y);
+                        mismatches += compareBar(generator, settings);
+                        ++bars;
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("{\"check\":\"drum_map_bars\",\"bars\":%ld,\"mismatches\":%ld}\n", bars, mismatches);
+
+    const int oneshotFailures = checkOneshot();
+    std::printf("{\"check\":\"oneshot\",\"failures\":%d}\n", oneshotFailures);
+    return mismatches || oneshotFailures ? 1 : 0;
+}
@@ -0,0 +1,427 @@
+//
+// PhasorBeatMapRender.cpp
+// Offline pattern renderer for PhasorBeatMap.
+//
+// This source code is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// -----------------------------------------------------------------------------
+//
+// Sweeps a grid of pattern settings through PatternGenerator, which has no Rack dependency, and
+// writes every resulting bar out as packed binary, CSV or a Standard MIDI File. Each axis is an
+// inclusive 0-255 range given as FROM:TO[:STEP] (or a single value):
+//
+//   PhasorBeatMapRender --modes original,henri,euclidean --x 0:255 --y 0:255 --out map.bin
+//
+// Bars are enumerated with y innermost, then x, hh, sd, bd, chaos, seed and mode outermost, and
+// the output is in that order whatever the thread count, so renders can be diffed directly.
+// In Euclidean mode x, y and chaos also set the three euclidean lengths, as they do on the panel.
+//
+// Binary output starts with a 16-byte header ("PBMR", then version, record count and record
+// size as little-endian uint32) followed by one 36-byte little-endian record per bar:
+//
+//   uint8  mode, x, y, bd, sd, hh, chaos, reserved
+//   uint32 seed
+//   uint32 triggers[3]   bit i = step i, BD/SD/HH
+//   uint32 accents[3]    Euclidean mode stores its reset bits here
+//
+// CSV output has one row per bar with the three parts drawn as 32-character strings
+// ('.' rest, 'x' trigger, 'X' accented trigger). MIDI output is a format 0 file at 96 PPQ where
+// each pattern takes 32 sixteenth notes, starts with a marker naming its settings, and plays
+// BD/SD/HH on GM notes 36/38/42.
+//
+// Usage: PhasorBeatMapRender [--modes LIST] [--x R] [--y R] [--bd R] [--sd R] [--hh R]
+//                            [--chaos R] [--seeds N] [--format bin|csv|midi] [--threads N]
+//                            [--out FILE]
+
+#include "../src/PhasorBeatMap/PhasorBeatMapPatternGenerator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum OutputFormat {
+    FORMAT_BINARY,
+    FORMAT_CSV,
+    FORMAT_MIDI
+};
+
+struct Range {
+    int from = 0;
+    int to = 0;
+    int step = 1;
+
+    int size() const {
+        return (to - from) / step + 1;
+    }
+    int at(int index) const {
+        return from + index * step;
+    }
+};
+
+// Sweep axes, outermost first
+enum Axis {
+    AXIS_MODE,
+    AXIS_SEED,
+    AXIS_CHAOS,
+    AXIS_BD,
+    AXIS_SD,
+    AXIS_HH,
+    AXIS_X,
+    AXIS_Y,
+    NUM_AXES
+};
+
+struct RenderSettings {
+    std::vector<PatternGeneratorMode> modes;
+    Range axes[NUM_AXES];
+    OutputFormat format = FORMAT_BINARY;
+    int threads = 0;
+    std::string outPath;
+
+    RenderSettings() {
+        axes[AXIS_X].to = 255;
+        axes[AXIS_Y].to = 255;
+        axes[AXIS_BD].from = axes[AXIS_BD].to = 128;
+        axes[AXIS_SD].from = axes[AXIS_SD].to = 128;
+        axes[AXIS_HH].from = axes[AXIS_HH].to = 128;
+    }
+};
+
+struct RenderedBar {
+    uint8_t mode;
+    uint8_t x, y;
+    uint8_t density[kNumParts];
+    uint8_t chaos;
+    uint32_t seed;
+    uint32_t triggerMask[kNumParts];
+    uint32_t accentMask[kNumParts];
+};
+
+const int kRecordSize = 36;
+const char* modeNames[] = {"henri", "original", "euclidean"};
+const uint8_t midiNotes[kNumParts] = {36, 38, 42};
+
+long countBars(const RenderSettings& settings) {
+    long count = 1;
+    for (int axis = 0; axis < NUM_AXES; ++axis) {
+        count *= settings.axes[axis].size();
+    }
+    return count;
+}
+
+// Renders bars [begin, end) of the sweep. Each thread has a generator of its own, since the
+// generator's drum map cache is not shared.
+void renderRange(const RenderSettings& settings, long begin, long end, PatternGenerator& generator,
+                 RenderedBar* out) {
+    for (long index = begin; index < end; ++index) {
+        int value[NUM_AXES];
+        long remainder = index;
+        for (int axis = NUM_AXES - 1; axis >= 0; --axis) {
+            const Range& range = settings.axes[axis];
+            value[axis] = range.at((int)(remainder % range.size()));
+            remainder /= range.size();
+        }
+
+        const PatternGeneratorMode mode = settings.modes[value[AXIS_MODE]];
+        const float x = value[AXIS_X] / 255.0f;
+        const float y = value[AXIS_Y] / 255.0f;
+        const float chaos = value[AXIS_CHAOS] / 255.0f;
+        generator.setPatternMode(mode);
+        generator.setMapX(x);
+        generator.setMapY(y);
+        generator.setBDDensity(value[AXIS_BD] / 255.0f);
+        generator.setSDDensity(value[AXIS_SD] / 255.0f);
+        generator.setHHDensity(value[AXIS_HH] / 255.0f);
+        generator.setRandomness(chaos);
+        generator.setEuclideanLength(0, x);
+        generator.setEuclideanLength(1, y);
+        generator.setEuclideanLength(2, chaos);
+
+        BarCache bar;
+        generator.setSeed((uint32_t)value[AXIS_SEED]);
+        generator.generateBar(bar);
+
+        RenderedBar& rendered = out[index - begin];
+        rendered.mode = (uint8_t)mode;
+        rendered.x = (uint8_t)value[AXIS_X];
+        rendered.y = (uint8_t)value[AXIS_Y];
+        rendered.density[0] = (uint8_t)value[AXIS_BD];
+        rendered.density[1] = (uint8_t)value[AXIS_SD];
+        rendered.density[2] = (uint8_t)value[AXIS_HH];
+        rendered.chaos = (uint8_t)value[AXIS_CHAOS];
+        rendered.seed = (uint32_t)value[AXIS_SEED];
+        // The generator is left at its default 32-step bars, which is what the record format holds
+        for (int i = 0; i < kNumParts; ++i) {
+            rendered.triggerMask[i] = static_cast<uint32_t>(bar.triggerMask[i]);
+            rendered.accentMask[i] = static_cast<uint32_t>(bar.accentMask[i]);
+        }
+    }
+}
+
+void renderAll(const RenderSettings& settings, std::vector<RenderedBar>& bars) {
+    const long count = (long)bars.size();
+    const long chunkSize = 4096;
+    int threadCount = settings.threads > 0 ? settings.threads : (int)std::thread::hardware_concurrency();
+    threadCount = std::max(1, std::min<int>(threadCount, (int)((count + chunkSize - 1) / chunkSize)));
+
+    // The generators are built here rather than in the threads: their constructor seeds from
+    // gam::rnd::getSeed(), which keeps unsynchronized static state. Every bar is seeded explicitly.
+    std::vector<PatternGenerator> generators(threadCount);
+
+    // Threads pull fixed-size chunks, so uneven chunk costs (Euclidean vs drum modes) even out
+    std::atomic<long> nextChunk(0);
+    auto worker = [&](PatternGenerator& generator) {
+        for (;;) {
+            const long begin = nextChunk.fetch_add(1) * chunkSize;
+            if (begin >= count) return;
+            const long end = std::min(count, begin + chunkSize);
+            renderRange(settings, begin, end, generator, &bars[begin]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker, std::ref(generators[i]));
+    }
+    worker(generators[0]);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void putU32(std::vector<uint8_t>& buffer, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        buffer.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+void writeBinary(const std::vector<RenderedBar>& bars, FILE* file) {
+    std::vector<uint8_t> buffer;
+    buffer.reserve(16 + bars.size() * kRecordSize);
+    buffer.insert(buffer.end(), {'P', 'B', 'M', 'R'});
+    putU32(buffer, 1);
+    putU32(buffer, (uint32_t)bars.size());
+    putU32(buffer, kRecordSize);
+
+    for (const RenderedBar& bar : bars) {
+        buffer.insert(buffer.end(), {bar.mode, bar.x, bar.y, bar.density[0], bar.density[1], bar.density[2],
+                                     bar.chaos, 0});
+        putU32(buffer, bar.seed);
+        for (int i = 0; i < kNumParts; ++i) {
+            putU32(buffer, bar.triggerMask[i]);
+        }
+        for (int i = 0; i < kNumParts; ++i) {
+            putU32(buffer, bar.accentMask[i]);
+        }
+    }
+    std::fwrite(buffer.data(), 1, buffer.size(), file);
+}
+
+void writeCSV(const std::vector<RenderedBar>& bars, FILE* file) {
+    std::fprintf(file, "mode,x,y,bd_density,sd_density,hh_density,chaos,seed,bd,sd,hh\n");
+    char steps[kNumParts][kStepsPerPattern + 1];
+    for (const RenderedBar& bar : bars) {
+        for (int i = 0; i < kNumParts; ++i) {
+            for (int step = 0; step < kStepsPerPattern; ++step) {
+                const bool trigger = (bar.triggerMask[i] >> step) & 1;
+                const bool accent = (bar.accentMask[i] >> step) & 1;
+                steps[i][step] = trigger ? (accent ? 'X' : 'x') : '.';
+            }
+            steps[i][kStepsPerPattern] = '\0';
+        }
+        std::fprintf(file, "%s,%d,%d,%d,%d,%d,%d,%u,%s,%s,%s\n", modeNames[bar.mode], bar.x, bar.y,
+                     bar.density[0], bar.density[1], bar.density[2], bar.chaos, bar.seed,
+                     steps[0], steps[1], steps[2]);
+    }
+}
+
+void putVariableLength(std::vector<uint8_t>& buffer, uint32_t value) {
+    uint8_t bytes[4];
+    int count = 0;
+    do {
+        bytes[count++] = value & 0x7F;
+        value >>= 7;
+    } while (value);
+    while (count--) {
+        buffer.push_back(bytes[count] | (count ? 0x80 : 0));
+    }
+}
+
+void writeMIDI(const std::vector<RenderedBar>& bars, FILE* file) {
+    const uint16_t ticksPerQuarter = 96;
+    const uint32_t ticksPerStep = ticksPerQuarter / 4;
+    const uint32_t noteLength = ticksPerStep / 2;
+
+    // Note-ons and note-offs never overlap, since notes end halfway through their step
+    std::vector<uint8_t> track;
+    uint32_t lastTick = 0;
+    uint32_t barTick = 0;
+    auto event = [&](uint32_t tick) {
+        putVariableLength(track, tick - lastTick);
+        lastTick = tick;
+    };
+
+    for (const RenderedBar& bar : bars) {
+        char marker[96];
+        const int length = std::snprintf(marker, sizeof(marker), "%s x=%d y=%d bd=%d sd=%d hh=%d chaos=%d seed=%u",
+                                         modeNames[bar.mode], bar.x, bar.y, bar.density[0], bar.density[1],
+                                         bar.density[2], bar.chaos, bar.seed);
+        event(barTick);
+        track.insert(track.end(), {0xFF, 0x06});
+        putVariableLength(track, (uint32_t)length);
+        track.insert(track.end(), marker, marker + length);
+
+        for (int step = 0; step < kStepsPerPattern; ++step) {
+            const uint32_t stepTick = barTick + step * ticksPerStep;
+            for (int i = 0; i < kNumParts; ++i) {
+                if ((bar.triggerMask[i] >> step) & 1) {
+                    event(stepTick);
+                    track.insert(track.end(), {0x99, midiNotes[i], (uint8_t)(((bar.accentMask[i] >> step) & 1) ? 127 : 96)});
+                }
+            }
+            for (int i = 0; i < kNumParts; ++i) {
+                if ((bar.triggerMask[i] >> step) & 1) {
+                    event(stepTick + noteLength);
+                    track.insert(track.end(), {0x89, midiNotes[i], 0});
+                }
+            }
+        }
+        barTick += kStepsPerPattern * ticksPerStep;
+    }
+    event(barTick);
+    track.insert(track.end(), {0xFF, 0x2F, 0x00});
+
+    const uint8_t header[] = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1,
+                              (uint8_t)(ticksPerQuarter >> 8), (uint8_t)ticksPerQuarter};
+    const uint32_t trackLength = (uint32_t)track.size();
+    const uint8_t trackHeader[] = {'M', 'T', 'r', 'k', (uint8_t)(trackLength >> 24), (uint8_t)(trackLength >> 16),
+                                   (uint8_t)(trackLength >> 8), (uint8_t)trackLength};
+    std::fwrite(header, 1, sizeof(header), file);
+    std::fwrite(trackHeader, 1, sizeof(trackHeader), file);
+    std::fwrite(track.data(), 1, track.size(), file);
+}
+
+bool parseRange(const char* text, int limit, Range& range) {
+    int values[3] = {0, 0, 1};
+    int count = std::sscanf(text, "%d:%d:%d", &values[0], &values[1], &values[2]);
+    if (count < 1) return false;
+    if (count == 1) values[1] = values[0];
+    if (values[0] < 0 || values[1] > limit || values[0] > values[1] || values[2] < 1) return false;
+    range.from = values[0];
+    range.to = values[1];
+    range.step = values[2];
+    return true;
+}
+
+bool parseModes(const char* text, std::vector<PatternGeneratorMode>& modes) {
+    modes.clear();
+    std::string list(text);
+    size_t start = 0;
+    while (start <= list.size()) {
+        const size_t comma = std::min(list.find(',', start), list.size());
+        const std::string name = list.substr(start, comma - start);
+        bool found = false;
+        for (int mode = PATTERN_HENRI; mode <= PATTERN_EUCLIDEAN; ++mode) {
+            if (name == modeNames[mode]) {
+                modes.push_back((PatternGeneratorMode)mode);
+                found = true;
+            }
+        }
+        if (!found) return false;
+        start = comma + 1;
+    }
+    return !modes.empty();
+}
+
+bool parseArguments(int argc, char** argv, RenderSettings& settings) {
+    const char* rangeOptions[NUM_AXES] = {nullptr, nullptr, "--chaos", "--bd", "--sd", "--hh", "--x", "--y"};
+    settings.modes = {PATTERN_ORIGINAL, PATTERN_HENRI, PATTERN_EUCLIDEAN};
+
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        bool parsed = false;
+        int rangeAxis = -1;
+        for (int axis = 0; axis < NUM_AXES; ++axis) {
+            if (rangeOptions[axis] && !std::strcmp(argv[i], rangeOptions[axis])) {
+                rangeAxis = axis;
+            }
+        }
+        if (hasValue) {
+            if (rangeAxis >= 0) {
+                parsed = parseRange(argv[++i], 255, settings.axes[rangeAxis]);
+            } else if (!std::strcmp(argv[i], "--modes")) {
+                parsed = parseModes(argv[++i], settings.modes);
+            } else if (!std::strcmp(argv[i], "--seeds")) {
+                const int seeds = std::atoi(argv[++i]);
+                settings.axes[AXIS_SEED].to = seeds - 1;
+                parsed = seeds > 0;
+            } else if (!std::strcmp(argv[i], "--threads")) {
+                settings.threads = std::max(0, std::atoi(argv[++i]));
+                parsed = true;
+            } else if (!std::strcmp(argv[i], "--out")) {
+                settings.outPath = argv[++i];
+                parsed = true;
+            } else if (!std::strcmp(argv[i], "--format")) {
+                const char* format = argv[++i];
+                parsed = true;
+                if (!std::strcmp(format, "bin")) settings.format = FORMAT_BINARY;
+                else if (!std::strcmp(format, "csv")) settings.format = FORMAT_CSV;
+                else if (!std::strcmp(format, "midi")) settings.format = FORMAT_MIDI;
+                else parsed = false;
+            }
+        }
+        if (!parsed) {
+            std::fprintf(stderr, "Usage: %s [--modes LIST] [--x R] [--y R] [--bd R] [--sd R] [--hh R] [--chaos R]\n"
+                                 "       [--seeds N] [--format bin|csv|midi] [--threads N] [--out FILE]\n"
+                                 "Ranges are FROM:TO[:STEP] within 0-255; modes are original, henri, euclidean.\n",
+                         argv[0]);
+            return false;
+        }
+    }
+    settings.axes[AXIS_MODE].to = (int)settings.modes.size() - 1;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    RenderSettings settings;
+    if (!parseArguments(argc, argv, settings)) {
+        return 1;
+    }
+
+    std::vector<RenderedBar> bars(countBars(settings));
+    renderAll(settings, bars);
+
+    FILE* file = settings.outPath.empty() ? stdout : std::fopen(settings.outPath.c_str(), "wb");
+    if (!file) {
+        std::fprintf(stderr, "Could not open %s for writing\n", settings.outPath.c_str());
+        return 1;
+    }
+    switch (settings.format) {
+        case FORMAT_BINARY: writeBinary(bars, file); break;
+        case FORMAT_CSV: writeCSV(bars, file); break;
+        case FORMAT_MIDI: writeMIDI(bars, file); break;
+    }
+    const bool failed = std::ferror(file) != 0;
+    if (file != stdout) {
+        std::fclose(file);
+    }
+    return failed ? 1 : 0;
+}